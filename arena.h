@@ -0,0 +1,347 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+/** arena allocation layer for decoder, book and output buffers
+ * memory comes in chunks of 2 MB huge pages, bound to the NUMA node of the allocating thread
+ * and pre-faulted, so the hot path never takes a page fault or a 4 KB TLB miss
+ * - allocate: bump allocation, freed all at once with the arena
+ * - allocate_block / deallocate_block: power of two size classes recycled through free lists,
+ *   what ArenaAllocator uses for node based and growing containers
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+#define HUGE_PAGE_SIZE (2ul << 20)
+#define SMALL_PAGE_SIZE 4096ul
+#define NUMA_MPOL_PREFERRED 1  // <numaif.h> MPOL_PREFERRED, without linking libnuma
+
+/**
+ * chunk level counters of every arena in the process
+ */
+struct ArenaStatistics
+{
+    std::atomic<uint64_t> chunks{0};
+    std::atomic<uint64_t> bytesReserved{0};
+    std::atomic<uint64_t> hugeTlbChunks{0};  // explicit huge pages, MAP_HUGETLB
+    std::atomic<uint64_t> transparentHugePageChunks{0};  // fallback, MADV_HUGEPAGE
+    std::atomic<uint64_t> numaBoundChunks{0};
+    std::atomic<uint64_t> prefaultFaults{0};
+
+    static ArenaStatistics &get() noexcept
+    {
+        static ArenaStatistics statistics;
+        return statistics;
+    }
+};
+
+inline int get_current_numa_node() noexcept
+{
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+        return -1;
+    return static_cast<int>(node);
+}
+
+inline uint64_t get_thread_page_faults() noexcept
+{
+    rusage usage;
+    if (::getrusage(RUSAGE_THREAD, &usage) != 0)
+        return 0;
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+/**
+ * huge page backed memory on the NUMA node of the calling thread, every page already faulted in
+ * @param size multiple of HUGE_PAGE_SIZE
+*/
+inline void *map_chunk(std::size_t size)
+{
+    ArenaStatistics &statistics = ArenaStatistics::get();
+    void *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED)
+        ++statistics.hugeTlbChunks;
+    else
+    {
+        /** no huge pages reserved in /proc/sys/vm/nr_hugepages, ask for transparent ones
+         * they only back 2 MB aligned ranges, map one huge page more and trim to an aligned start */
+        void *mapped = ::mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED)
+            throw std::bad_alloc();
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(mapped);
+        const uintptr_t aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if (aligned > begin)
+            ::munmap(mapped, aligned - begin);
+        if (begin + HUGE_PAGE_SIZE > aligned)
+            ::munmap(reinterpret_cast<void *>(aligned + size), begin + HUGE_PAGE_SIZE - aligned);
+        addr = reinterpret_cast<void *>(aligned);
+        if (::madvise(addr, size, MADV_HUGEPAGE) == 0)
+            ++statistics.transparentHugePageChunks;
+    }
+
+    /** preferred rather than strict binding, a full node falls back instead of failing the allocation */
+    const int node = get_current_numa_node();
+    if (node >= 0 && node < 64)
+    {
+        const unsigned long nodeMask = 1ul << node;
+        if (::syscall(SYS_mbind, addr, size, NUMA_MPOL_PREFERRED, &nodeMask, 64, 0) == 0)
+            ++statistics.numaBoundChunks;
+    }
+
+    const uint64_t faultsBefore = get_thread_page_faults();
+    volatile char *page = static_cast<volatile char *>(addr);
+    for (std::size_t offset = 0; offset < size; offset += SMALL_PAGE_SIZE)
+        page[offset] = 0;
+    statistics.prefaultFaults += get_thread_page_faults() - faultsBefore;
+    ++statistics.chunks;
+    statistics.bytesReserved += size;
+    return addr;
+}
+
+class Arena
+{
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = HUGE_PAGE_SIZE;
+    static constexpr std::size_t MIN_BLOCK_SIZE = 16;
+    static constexpr std::size_t MAX_BLOCK_ALIGNMENT = 64;
+
+    explicit Arena(std::size_t chunkSize = DEFAULT_CHUNK_SIZE)
+        : mChunkSize(round_up(chunkSize, HUGE_PAGE_SIZE))
+    {
+        mFreeLists.fill(nullptr);
+    }
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena()
+    {
+        for (const auto &[chunk, size] : mChunks)
+            ::munmap(chunk, size);
+    }
+
+    /**
+     * one arena per thread, its chunks on the node the thread runs on
+    */
+    static Arena &local()
+    {
+        static thread_local Arena arena;
+        return arena;
+    }
+
+    /**
+     * @note a request larger than a chunk gets a mapping of its own, the current chunk keeps serving the small ones
+    */
+    void *allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+        mBytesAllocated += size;
+        if (is_large(size, alignment))
+            return map_large(size);
+        uintptr_t ptr = round_up(reinterpret_cast<uintptr_t>(mCursor), alignment);
+        if (ptr + size > reinterpret_cast<uintptr_t>(mEnd))
+        {
+            mCursor = static_cast<char *>(map_chunk(mChunkSize));
+            mEnd = mCursor + mChunkSize;
+            mChunks.emplace_back(mCursor, mChunkSize);
+            mBytesReserved += mChunkSize;
+            ptr = round_up(reinterpret_cast<uintptr_t>(mCursor), alignment);
+        }
+        mCursor = reinterpret_cast<char *>(ptr + size);
+        return reinterpret_cast<void *>(ptr);
+    }
+
+    /**
+     * @note destructors are never run, meant for trivially destructible types
+    */
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * a block larger than a chunk is unmapped when given back instead of waiting in a free list
+    */
+    void *allocate_block(std::size_t size)
+    {
+        const std::size_t sizeClass = get_size_class(size);
+        const std::size_t blockSize = std::size_t(1) << sizeClass;
+        const std::size_t alignment = blockSize < MAX_BLOCK_ALIGNMENT ? blockSize : MAX_BLOCK_ALIGNMENT;
+        if (is_large(blockSize, alignment))
+            return allocate(blockSize, alignment);
+        void *&freeList = mFreeLists[sizeClass];
+        if (freeList)
+        {
+            void *block = freeList;
+            freeList = *static_cast<void **>(block);
+            mBytesFree -= blockSize;
+            return block;
+        }
+        return allocate(blockSize, alignment);
+    }
+
+    void deallocate_block(void *block, std::size_t size) noexcept
+    {
+        const std::size_t sizeClass = get_size_class(size);
+        const std::size_t blockSize = std::size_t(1) << sizeClass;
+        if (is_large(blockSize, blockSize < MAX_BLOCK_ALIGNMENT ? blockSize : MAX_BLOCK_ALIGNMENT))
+        {
+            unmap_large(block, blockSize);
+            return;
+        }
+        *static_cast<void **>(block) = mFreeLists[sizeClass];
+        mFreeLists[sizeClass] = block;
+        mBytesFree += blockSize;
+    }
+
+    std::size_t get_bytes_allocated() const noexcept
+    {
+        return mBytesAllocated;
+    }
+
+    std::size_t get_bytes_reserved() const noexcept
+    {
+        return mBytesReserved;
+    }
+
+    /** blocks given back and waiting in the free lists */
+    std::size_t get_bytes_free() const noexcept
+    {
+        return mBytesFree;
+    }
+
+private:
+    static constexpr uintptr_t round_up(uintptr_t value, std::size_t alignment) noexcept
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool is_large(std::size_t size, std::size_t alignment) const noexcept
+    {
+        return size + alignment > mChunkSize;
+    }
+
+    void *map_large(std::size_t size)
+    {
+        const std::size_t mappedSize = round_up(size, HUGE_PAGE_SIZE);
+        void *mapping = map_chunk(mappedSize);
+        mChunks.emplace_back(mapping, mappedSize);
+        mBytesReserved += mappedSize;
+        return mapping;
+    }
+
+    void unmap_large(void *block, std::size_t size) noexcept
+    {
+        for (std::size_t i = 0; i < mChunks.size(); ++i)
+        {
+            if (mChunks[i].first != block)
+                continue;
+            ::munmap(block, mChunks[i].second);
+            mBytesReserved -= mChunks[i].second;
+            mBytesAllocated -= size;
+            mChunks[i] = mChunks.back();
+            mChunks.pop_back();
+            return;
+        }
+    }
+
+    static std::size_t get_size_class(std::size_t size) noexcept
+    {
+        if (size <= MIN_BLOCK_SIZE)
+            return 4;
+        return 64 - __builtin_clzl(size - 1);
+    }
+
+    const std::size_t mChunkSize;
+    std::vector<std::pair<void *, std::size_t>> mChunks;
+    std::array<void *, 64> mFreeLists;
+    char *mCursor = nullptr;
+    char *mEnd = nullptr;
+    std::size_t mBytesAllocated = 0;
+    std::size_t mBytesReserved = 0;
+    std::size_t mBytesFree = 0;
+};
+
+/**
+ * standard allocator on an arena, the thread's own arena by default
+ * @note an arena is not thread safe, a container stays on the thread that built it
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept
+        : mArena(&Arena::local())
+    {
+    }
+    explicit ArenaAllocator(Arena &arena) noexcept
+        : mArena(&arena)
+    {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+        : mArena(other.get_arena())
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(mArena->allocate_block(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept
+    {
+        mArena->deallocate_block(ptr, n * sizeof(T));
+    }
+
+    Arena *get_arena() const noexcept
+    {
+        return mArena;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const noexcept
+    {
+        return mArena == other.get_arena();
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const noexcept
+    {
+        return mArena != other.get_arena();
+    }
+
+private:
+    Arena *mArena;
+};
+
+inline void report_arena_statistics(std::FILE *out)
+{
+    const ArenaStatistics &statistics = ArenaStatistics::get();
+    const Arena &arena = Arena::local();
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    std::fprintf(out, "\narena,value\n");
+    std::fprintf(out, "chunks,%lu\nbytes reserved,%lu\nhugetlb chunks,%lu\ntransparent huge page chunks,%lu\n",
+        statistics.chunks.load(), statistics.bytesReserved.load(),
+        statistics.hugeTlbChunks.load(), statistics.transparentHugePageChunks.load());
+    std::fprintf(out, "numa bound chunks,%lu\nprefault page faults,%lu\n",
+        statistics.numaBoundChunks.load(), statistics.prefaultFaults.load());
+    std::fprintf(out, "thread arena bytes allocated,%lu\nthread arena bytes free,%lu\n",
+        arena.get_bytes_allocated(), arena.get_bytes_free());
+    std::fprintf(out, "process minor page faults,%ld\nprocess major page faults,%ld\n",
+        usage.ru_minflt, usage.ru_majflt);
+}
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,225 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <unordered_set>
+
+#include "constants.h"
+#include "utils.h"
+#include "itch_protocol.h"
+#include "book_table.h"
+
+/** auction analytics, follows OrderBookState transitions and the EquilibriumPriceUpdate flood in between
+ * one summary line per state change instead of one line per equilibrium update
+ * summary = book, from state, to state, time, equilibrium updates, last equilibrium price, bid and ask quantity,
+ *           imbalance, indicated volume, uncross price, uncross volume, uncross trades, uncross price == equilibrium price
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+struct AuctionState
+{
+    Alpha_t<20> stateName;
+    bool hasState = false;
+
+    /** equilibrium of the current state, zero updates means no auction */
+    uint32_t updates = 0;
+    Price_t equilibriumPrice = 0;
+    Numeric8_t bidQuantity = 0;
+    Numeric8_t askQuantity = 0;
+
+    /** executions at the cross, before or after the state change that ends the auction */
+    uint32_t uncrossTrades = 0;
+    Numeric8_t uncrossVolume = 0;
+    Price_t uncrossPrice = 0;
+    bool hasUncrossPrice = false;  // false while only OrderExecuted, which carries no price, was seen
+    std::unordered_set<Numeric8_t> uncrossMatchIds;
+
+    /** summary held back until the uncross executions are over */
+    bool summaryPending = false;
+    bool hasFromState = false;
+    Alpha_t<20> fromState;
+    uint64_t changedAtNs = 0;
+};
+
+class AuctionTracker
+{
+public:
+    explicit AuctionTracker(std::ostream &out)
+        : mOut(out)
+    {
+    }
+
+    void on_message(const MessageInfo *msgInfo)
+    {
+        switch (msgInfo->get_message_type())
+        {
+        case MessageType::Seconds:
+            mSecond = big_endian_to_host(static_cast<const Seconds *>(msgInfo)->second);
+            break;
+        case MessageType::OrderBookState:
+            on_state(static_cast<const OrderBookState *>(msgInfo));
+            break;
+        case MessageType::EquilibriumPriceUpdate:
+            on_equilibrium(static_cast<const EquilibriumPriceUpdate *>(msgInfo));
+            break;
+        case MessageType::OrderExecuted:
+            on_order_executed(static_cast<const OrderExecuted *>(msgInfo));
+            break;
+        case MessageType::OrderExecutedWithPrice:
+        {
+            const OrderExecutedWithPrice *feed = static_cast<const OrderExecutedWithPrice *>(msgInfo);
+            on_execution(big_endian_to_host(feed->mOrderBookId), big_endian_to_host(feed->mMatchId),
+                big_endian_to_host(feed->mExecutedQuantity), big_endian_to_host(feed->mTradePrice), feed->mOccurredAtCross);
+            break;
+        }
+        case MessageType::TradeMessageIdentifier:
+        {
+            const Trade *feed = static_cast<const Trade *>(msgInfo);
+            on_execution(big_endian_to_host(feed->mOrderBookId), big_endian_to_host(feed->mMatchId),
+                big_endian_to_host(feed->mQuantity), big_endian_to_host(feed->mTradePrice), feed->mOccurredAtCross);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    /**
+     * flush the summaries still waiting for uncross executions
+    */
+    void finish()
+    {
+        mBooks.for_each([this](Numeric4_t orderBookId, AuctionState &state)
+        {
+            if (state.summaryPending)
+                emit(orderBookId, state);
+        });
+    }
+
+    uint64_t get_summary_count() const noexcept
+    {
+        return mSummaries;
+    }
+
+private:
+    uint64_t get_time_ns(Numeric4_t nanoseconds) const noexcept
+    {
+        return static_cast<uint64_t>(mSecond) * 1000000000ull + nanoseconds;
+    }
+
+    void on_state(const OrderBookState *feed)
+    {
+        const Numeric4_t orderBookId = big_endian_to_host(feed->mOrderBookId);
+        AuctionState &state = mBooks[orderBookId];
+        if (state.summaryPending)
+            emit(orderBookId, state);
+        state.summaryPending = true;
+        state.hasFromState = state.hasState;
+        state.fromState = state.stateName;
+        state.changedAtNs = get_time_ns(big_endian_to_host(feed->mTimestampNanoseconds));
+        state.stateName = feed->mStateName;
+        state.hasState = true;
+        if (state.updates == 0 && state.uncrossTrades == 0)
+        {
+            /** no auction in the state left behind, nothing to wait for */
+            emit(orderBookId, state);
+        }
+    }
+
+    void on_equilibrium(const EquilibriumPriceUpdate *feed)
+    {
+        const Numeric4_t orderBookId = big_endian_to_host(feed->mOrderBookId);
+        AuctionState &state = mBooks[orderBookId];
+        if (state.summaryPending)
+            emit(orderBookId, state);
+        ++state.updates;
+        state.equilibriumPrice = big_endian_to_host(feed->mEquilibriumPrice);
+        state.bidQuantity = big_endian_to_host(feed->mAvailableBidQuantityAtEquilibriumPrice);
+        state.askQuantity = big_endian_to_host(feed->mAvailableAskQuantityAtEquilibriumPrice);
+    }
+
+    void on_execution(Numeric4_t orderBookId, Numeric8_t matchId, Numeric8_t quantity, Price_t price, char occurredAtCross)
+    {
+        AuctionState *state = mBooks.find(orderBookId);
+        if (!state)
+            return;
+        if (occurredAtCross != 'Y')
+        {
+            /** continuous trading again, the uncross is over */
+            if (state->summaryPending)
+                emit(orderBookId, *state);
+            return;
+        }
+        count_uncross(*state, matchId, quantity);
+        state->uncrossPrice = price;
+        state->hasUncrossPrice = true;
+    }
+
+    /**
+     * an order filled at its own limit price, no price and no cross flag,
+     * part of the uncross while the book is in an auction or its summary is pending
+    */
+    void on_order_executed(const OrderExecuted *feed)
+    {
+        AuctionState *state = mBooks.find(big_endian_to_host(feed->mOrderBookId));
+        if (!state || (state->updates == 0 && !state->summaryPending))
+            return;
+        count_uncross(*state, big_endian_to_host(feed->mMatchId), big_endian_to_host(feed->mExecutedQuantity));
+    }
+
+    /**
+     * both sides of a match are reported with the same match id, not necessarily one after the other,
+     * the match is counted once
+    */
+    void count_uncross(AuctionState &state, Numeric8_t matchId, Numeric8_t quantity)
+    {
+        if (!state.uncrossMatchIds.insert(matchId).second)
+            return;
+        ++state.uncrossTrades;
+        state.uncrossVolume += quantity;
+    }
+
+    void emit(Numeric4_t orderBookId, AuctionState &state)
+    {
+        const Numeric8_t indicatedVolume = state.bidQuantity < state.askQuantity ? state.bidQuantity : state.askQuantity;
+        const int64_t imbalance = static_cast<int64_t>(state.bidQuantity) - static_cast<int64_t>(state.askQuantity);
+        char buffer[MAX_LEN_PER_MESSAGE];
+        std::snprintf(buffer, sizeof(buffer), "%u,%s,%s,%lu,%u,%d,%lu,%lu,%ld,%lu,%d,%lu,%u,%s",
+            orderBookId,
+            state.hasFromState ? alpha_to_string(state.fromState).c_str() : "",
+            alpha_to_string(state.stateName).c_str(),
+            state.changedAtNs,
+            state.updates,
+            state.equilibriumPrice,
+            state.bidQuantity,
+            state.askQuantity,
+            imbalance,
+            indicatedVolume,
+            state.uncrossPrice,
+            state.uncrossVolume,
+            state.uncrossTrades,
+            !state.hasUncrossPrice ? "" : (state.uncrossPrice == state.equilibriumPrice ? "Y" : "N"));
+        mOut << buffer << '\n';
+        ++mSummaries;
+
+        state.summaryPending = false;
+        state.updates = 0;
+        state.equilibriumPrice = 0;
+        state.bidQuantity = 0;
+        state.askQuantity = 0;
+        state.uncrossTrades = 0;
+        state.uncrossVolume = 0;
+        state.uncrossPrice = 0;
+        state.hasUncrossPrice = false;
+        state.uncrossMatchIds.clear();
+    }
+
+    std::ostream &mOut;
+    BookTable<AuctionState> mBooks;
+    Numeric4_t mSecond = 0;
+    uint64_t mSummaries = 0;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "constants.h"
+#include "arena.h"
+
+/** per Order Book state in a flat table indexed by Order Book ID
+ * ids are small dense numbers in practice, the rare large one falls back to a hash map
+ * both live in the thread's arena
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+template <typename T>
+class BookTable
+{
+public:
+    static constexpr Numeric4_t MAX_DENSE_ID = 1 << 20;
+
+    /**
+     * default constructs the entry of a book seen for the first time
+    */
+    T &operator[](Numeric4_t orderBookId)
+    {
+        if (orderBookId < MAX_DENSE_ID)
+        {
+            if (orderBookId >= mDense.size())
+            {
+                mDense.resize(orderBookId + 1);
+                mUsed.resize(orderBookId + 1, false);
+            }
+            mUsed[orderBookId] = true;
+            return mDense[orderBookId];
+        }
+        return mSparse[orderBookId];
+    }
+
+    /**
+     * preallocate the dense part for ids below count
+    */
+    void reserve(Numeric4_t count)
+    {
+        mDense.reserve(count < MAX_DENSE_ID ? count : MAX_DENSE_ID);
+        mUsed.reserve(count < MAX_DENSE_ID ? count : MAX_DENSE_ID);
+    }
+
+    T *find(Numeric4_t orderBookId) noexcept
+    {
+        if (orderBookId < MAX_DENSE_ID)
+            return orderBookId < mDense.size() && mUsed[orderBookId] ? &mDense[orderBookId] : nullptr;
+        auto it = mSparse.find(orderBookId);
+        return it == mSparse.end() ? nullptr : &it->second;
+    }
+
+    const T *find(Numeric4_t orderBookId) const noexcept
+    {
+        return const_cast<BookTable *>(this)->find(orderBookId);
+    }
+
+    /**
+     * visit(orderBookId, entry) for every book seen, in ascending id order for the dense part
+    */
+    template <typename Visitor>
+    void for_each(Visitor &&visit)
+    {
+        for (std::size_t id = 0; id < mDense.size(); ++id)
+        {
+            if (mUsed[id])
+                visit(static_cast<Numeric4_t>(id), mDense[id]);
+        }
+        for (auto &[id, entry] : mSparse)
+            visit(id, entry);
+    }
+
+    void clear()
+    {
+        mDense.clear();
+        mUsed.clear();
+        mSparse.clear();
+    }
+
+private:
+    std::vector<T, ArenaAllocator<T>> mDense;
+    std::vector<bool, ArenaAllocator<bool>> mUsed;
+    std::unordered_map<Numeric4_t, T, std::hash<Numeric4_t>, std::equal_to<Numeric4_t>,
+        ArenaAllocator<std::pair<const Numeric4_t, T>>> mSparse;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,311 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <unordered_map>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "arena.h"
+#include "message_view.h"
+
+/** message for message comparison of two captures of the same sessions, e.g. before and after a network change
+ * both captures are streamed side by side and aligned on MoldUDP64 session + sequence number,
+ * a message waits in a bounded window until its counterpart shows up on the other side
+ * - missing: in the first capture only, evicted from the window or left at the end
+ * - extra: in the second capture only
+ * - mismatch: same session and sequence number, different message block bytes
+ * - duplicate: a session and sequence number already in the window of either capture, matched or not
+ * one line per difference = kind, session, sequence number, message type, capture time a, capture time b,
+ *                           capture time b - a, first differing byte of the message block
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+struct DiffKey
+{
+    Alpha_t<SESSION_LENGTH> session;
+    uint64_t sequenceNumber;
+
+    bool operator==(const DiffKey &other) const noexcept
+    {
+        return sequenceNumber == other.sequenceNumber && session == other.session;
+    }
+};
+
+struct DiffKeyHash
+{
+    std::size_t operator()(const DiffKey &key) const noexcept
+    {
+        uint64_t session;
+        std::memcpy(&session, key.session.data() + SESSION_LENGTH - sizeof(session), sizeof(session));
+        return key.sequenceNumber * 0x9E3779B97F4A7C15ull ^ session;
+    }
+};
+
+struct DiffStatistics
+{
+    uint64_t matched = 0;
+    uint64_t mismatched = 0;
+    uint64_t missing = 0;
+    uint64_t extra = 0;
+    uint64_t duplicates = 0;  // same session and sequence number again while it is held in either window
+    int64_t minDeltaNs = 0;
+    int64_t maxDeltaNs = 0;
+    int64_t totalDeltaNs = 0;  // over matched and mismatched messages
+};
+
+/**
+ * messages of one capture waiting for their counterpart, oldest first
+ */
+class DiffWindow
+{
+public:
+    /**
+     * @param waiting false for a message already matched, held so that a later copy counts as a duplicate
+     * @return false if the key is already in the window, waiting or matched
+    */
+    bool push(const DiffKey &key, const MessageView &view, bool waiting = true)
+    {
+        if (!mPositions.emplace(key, mFront + mPending.size()).second)
+            return false;
+        mPending.push_back(PendingMessage{key, view, waiting});
+        return true;
+    }
+
+    /**
+     * @return true if the key is in the window, waiting or matched
+    */
+    bool contains(const DiffKey &key) const
+    {
+        return mPositions.count(key) != 0;
+    }
+
+    /**
+     * take the message waiting under key, its key stays in the window as matched until evicted
+     * @return false if no message is waiting under key
+    */
+    bool take(const DiffKey &key, MessageView &view)
+    {
+        auto it = mPositions.find(key);
+        if (it == mPositions.end())
+            return false;
+        PendingMessage &pending = mPending[it->second - mFront];
+        if (!pending.waiting)
+            return false;
+        view = pending.view;
+        pending.waiting = false;
+        return true;
+    }
+
+    /**
+     * drop the oldest entry
+     * @return true if it was still waiting, key and view are then filled
+    */
+    bool pop(DiffKey &key, MessageView &view)
+    {
+        const PendingMessage pending = mPending.front();
+        mPending.pop_front();
+        ++mFront;
+        mPositions.erase(pending.key);
+        if (!pending.waiting)
+            return false;
+        key = pending.key;
+        view = pending.view;
+        return true;
+    }
+
+    /**
+     * entries held, matched ones included until evicted
+    */
+    std::size_t size() const noexcept
+    {
+        return mPending.size();
+    }
+
+private:
+    struct PendingMessage
+    {
+        DiffKey key;
+        MessageView view;
+        bool waiting;  // false once matched, dropped when evicted
+    };
+
+    std::deque<PendingMessage> mPending;
+    uint64_t mFront = 0;  // position of mPending.front() since the first push
+    std::unordered_map<DiffKey, uint64_t, DiffKeyHash, std::equal_to<DiffKey>,
+        ArenaAllocator<std::pair<const DiffKey, uint64_t>>> mPositions;
+};
+
+class CaptureDiff
+{
+public:
+    static constexpr std::size_t DEFAULT_WINDOW = 1 << 16;
+    static constexpr std::size_t BATCH_SIZE = 256;
+
+    /**
+     * @param window messages per capture held while waiting for a counterpart, the older ones are reported
+     * @note at least two batches, the other side catches up a batch at a time
+    */
+    CaptureDiff(std::ostream &out, std::size_t window = DEFAULT_WINDOW)
+        : mOut(out), mWindow(window > 2 * BATCH_SIZE ? window : 2 * BATCH_SIZE)
+    {
+    }
+
+    /**
+     * one pass over both captures, batches are taken from each side in turn
+    */
+    void run(PcapFile &first, PcapFile &second)
+    {
+        MessageReader firstReader(first);
+        MessageReader secondReader(second);
+        MessageView views[BATCH_SIZE];
+        bool firstMore = true;
+        bool secondMore = true;
+        while (firstMore || secondMore)
+        {
+            if (firstMore)
+            {
+                const std::size_t count = firstReader.next_batch(views, BATCH_SIZE);
+                firstMore = count > 0;
+                for (std::size_t i = 0; i < count; ++i)
+                    on_message(views[i], mFirstWindow, mSecondWindow, true);
+            }
+            if (secondMore)
+            {
+                const std::size_t count = secondReader.next_batch(views, BATCH_SIZE);
+                secondMore = count > 0;
+                for (std::size_t i = 0; i < count; ++i)
+                    on_message(views[i], mSecondWindow, mFirstWindow, false);
+            }
+        }
+        finish();
+    }
+
+    const DiffStatistics &get_statistics() const noexcept
+    {
+        return mStatistics;
+    }
+
+private:
+    void on_message(const MessageView &view, DiffWindow &own, DiffWindow &other, bool isFirst)
+    {
+        const DiffKey key{view.get_session(), view.sequenceNumber};
+        /** a retransmission seen before or after the match, on either side, while the original is in the window */
+        if (own.contains(key))
+        {
+            ++mStatistics.duplicates;
+            return;
+        }
+        MessageView counterpart;
+        if (other.take(key, counterpart))
+        {
+            if (isFirst)
+                compare(view, counterpart);
+            else
+                compare(counterpart, view);
+            own.push(key, view, false);
+        }
+        else if (other.contains(key))
+        {
+            ++mStatistics.duplicates;
+            return;
+        }
+        else
+            own.push(key, view);
+        DiffKey evictedKey;
+        MessageView evicted;
+        while (own.size() > mWindow)
+        {
+            if (own.pop(evictedKey, evicted))
+                report_unmatched(evicted, isFirst);
+        }
+    }
+
+    void compare(const MessageView &first, const MessageView &second)
+    {
+        const int64_t deltaNs = static_cast<int64_t>(second.captureTimeNs - first.captureTimeNs);
+        if (mStatistics.matched + mStatistics.mismatched == 0)
+            mStatistics.minDeltaNs = mStatistics.maxDeltaNs = deltaNs;
+        if (deltaNs < mStatistics.minDeltaNs)
+            mStatistics.minDeltaNs = deltaNs;
+        if (deltaNs > mStatistics.maxDeltaNs)
+            mStatistics.maxDeltaNs = deltaNs;
+        mStatistics.totalDeltaNs += deltaNs;
+
+        /** length prefix and message data in one memcmp, vectorized by the C library */
+        const std::size_t firstLen = first.block->get_size();
+        const std::size_t secondLen = second.block->get_size();
+        if (firstLen == secondLen && std::memcmp(first.block, second.block, firstLen) == 0)
+        {
+            ++mStatistics.matched;
+            return;
+        }
+        ++mStatistics.mismatched;
+        const u_char *firstBytes = reinterpret_cast<const u_char *>(first.block);
+        const u_char *secondBytes = reinterpret_cast<const u_char *>(second.block);
+        std::size_t offset = 0;
+        while (offset < firstLen && offset < secondLen && firstBytes[offset] == secondBytes[offset])
+            ++offset;
+        write_line("mismatch", first, first.captureTimeNs, second.captureTimeNs, true, offset);
+    }
+
+    void report_unmatched(const MessageView &view, bool isFirst)
+    {
+        if (isFirst)
+        {
+            ++mStatistics.missing;
+            write_line("missing", view, view.captureTimeNs, 0, false, 0);
+        }
+        else
+        {
+            ++mStatistics.extra;
+            write_line("extra", view, 0, view.captureTimeNs, false, 0);
+        }
+    }
+
+    void finish()
+    {
+        DiffKey key;
+        MessageView view;
+        while (mFirstWindow.size())
+        {
+            if (mFirstWindow.pop(key, view))
+                report_unmatched(view, true);
+        }
+        while (mSecondWindow.size())
+        {
+            if (mSecondWindow.pop(key, view))
+                report_unmatched(view, false);
+        }
+    }
+
+    void write_line(const char *kind, const MessageView &view, uint64_t firstTimeNs, uint64_t secondTimeNs,
+        bool matched, std::size_t offset)
+    {
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer), "%s,%s,%lu,%c,%lu,%lu,%s,%s",
+            kind,
+            alpha_to_string(view.get_session()).c_str(),
+            view.sequenceNumber,
+            static_cast<char>(view.get_message_type()),
+            firstTimeNs,
+            secondTimeNs,
+            matched ? std::to_string(static_cast<int64_t>(secondTimeNs - firstTimeNs)).c_str() : "",
+            matched ? std::to_string(offset).c_str() : "");
+        mOut << buffer << '\n';
+    }
+
+    std::ostream &mOut;
+    const std::size_t mWindow;
+    DiffWindow mFirstWindow;
+    DiffWindow mSecondWindow;
+    DiffStatistics mStatistics;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,203 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "constants.h"
+#include "utils.h"
+#include "itch_protocol.h"
+#include "book_table.h"
+
+/** combination Order Books, legs from CombinationOrderBookLeg and executions linked by ComboGroupId
+ * a combination trade prints executions on the combination Order Book and trades on every leg,
+ * all of them carry the same ComboGroupId
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+struct CombinationLeg
+{
+    Numeric4_t legOrderBookId;
+    /**
+     * - 'B' = As Defined
+     * - 'C' = Opposite
+    */
+    char legSide;
+    Numeric4_t legRatio;
+};
+
+struct ComboExecution
+{
+    Numeric4_t orderBookId;
+    char side;
+    Numeric8_t quantity;
+    Numeric8_t matchId;
+    Price_t price;
+    bool hasPrice;  // OrderExecuted carries no price
+};
+
+struct ComboGroup
+{
+    Numeric4_t combinationOrderBookId = 0;  // 0 until an execution on the combination Order Book is seen
+    std::vector<ComboExecution> comboExecutions;
+    std::vector<ComboExecution> legTrades;
+};
+
+class CombinationRegistry
+{
+public:
+    void on_message(const MessageInfo *msgInfo)
+    {
+        switch (msgInfo->get_message_type())
+        {
+        case MessageType::CombinationOrderBookLeg:
+        {
+            const CombinationOrderBookLeg *feed = static_cast<const CombinationOrderBookLeg *>(msgInfo);
+            add_leg(big_endian_to_host(feed->mCombinationOrderBookId), CombinationLeg{
+                big_endian_to_host(feed->mLegOrderBookId),
+                feed->mLegSide,
+                big_endian_to_host(feed->mLegRatio)});
+            break;
+        }
+        case MessageType::OrderExecuted:
+        {
+            const OrderExecuted *feed = static_cast<const OrderExecuted *>(msgInfo);
+            on_execution(big_endian_to_host(feed->mComboGroupId), ComboExecution{
+                big_endian_to_host(feed->mOrderBookId), feed->mSide, big_endian_to_host(feed->mExecutedQuantity),
+                big_endian_to_host(feed->mMatchId), 0, false});
+            break;
+        }
+        case MessageType::OrderExecutedWithPrice:
+        {
+            const OrderExecutedWithPrice *feed = static_cast<const OrderExecutedWithPrice *>(msgInfo);
+            on_execution(big_endian_to_host(feed->mComboGroupId), ComboExecution{
+                big_endian_to_host(feed->mOrderBookId), feed->mSide, big_endian_to_host(feed->mExecutedQuantity),
+                big_endian_to_host(feed->mMatchId), big_endian_to_host(feed->mTradePrice), true});
+            break;
+        }
+        case MessageType::TradeMessageIdentifier:
+        {
+            const Trade *feed = static_cast<const Trade *>(msgInfo);
+            on_execution(big_endian_to_host(feed->mComboGroupId), ComboExecution{
+                big_endian_to_host(feed->mOrderBookId), feed->mSide, big_endian_to_host(feed->mQuantity),
+                big_endian_to_host(feed->mMatchId), big_endian_to_host(feed->mTradePrice), true});
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    /**
+     * @return nullptr for an Order Book that is not a combination
+    */
+    const std::vector<CombinationLeg> *find_legs(Numeric4_t combinationOrderBookId) const noexcept
+    {
+        return mLegs.find(combinationOrderBookId);
+    }
+
+    const ComboGroup *find_group(Numeric4_t comboGroupId) const noexcept
+    {
+        auto it = mGroups.find(comboGroupId);
+        return it == mGroups.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * visit(comboGroupId, group) in the order the groups first appeared
+    */
+    template <typename Visitor>
+    void for_each_group(Visitor &&visit) const
+    {
+        for (Numeric4_t comboGroupId : mGroupOrder)
+            visit(comboGroupId, mGroups.at(comboGroupId));
+    }
+
+    /**
+     * volume weighted price of the executions on one Order Book, each match counted once
+     * @return false without a priced execution
+    */
+    static bool get_average_price(const std::vector<ComboExecution> &executions, Numeric4_t orderBookId,
+        double &price, Numeric8_t &quantity)
+    {
+        std::unordered_set<Numeric8_t> matches;
+        double notional = 0;
+        quantity = 0;
+        for (const ComboExecution &execution : executions)
+        {
+            if (execution.orderBookId != orderBookId || !execution.hasPrice || !matches.insert(execution.matchId).second)
+                continue;
+            notional += static_cast<double>(execution.price) * execution.quantity;
+            quantity += execution.quantity;
+        }
+        if (quantity == 0)
+            return false;
+        price = notional / quantity;
+        return true;
+    }
+
+    /**
+     * combination price implied by the leg trades, sum of ratio * leg price,
+     * legs traded opposite to the definition count negative
+     * @return false if a leg has no priced trade in the group
+    */
+    bool get_implied_price(const ComboGroup &group, double &impliedPrice) const
+    {
+        const std::vector<CombinationLeg> *legs = find_legs(group.combinationOrderBookId);
+        if (!legs || legs->empty())
+            return false;
+        impliedPrice = 0;
+        for (const CombinationLeg &leg : *legs)
+        {
+            double legPrice;
+            Numeric8_t legQuantity;
+            if (!get_average_price(group.legTrades, leg.legOrderBookId, legPrice, legQuantity))
+                return false;
+            impliedPrice += (leg.legSide == 'C' ? -1.0 : 1.0) * leg.legRatio * legPrice;
+        }
+        return true;
+    }
+
+private:
+    /**
+     * a leg is keyed on (combination Order Book, leg Order Book), reference data seen again,
+     * e.g. on the A and B lines or in a re-sent snapshot, replaces the leg instead of adding it twice
+    */
+    void add_leg(Numeric4_t combinationOrderBookId, const CombinationLeg &leg)
+    {
+        std::vector<CombinationLeg> &legs = mLegs[combinationOrderBookId];
+        for (CombinationLeg &existing : legs)
+        {
+            if (existing.legOrderBookId == leg.legOrderBookId)
+            {
+                existing = leg;
+                return;
+            }
+        }
+        legs.push_back(leg);
+    }
+
+    void on_execution(Numeric4_t comboGroupId, const ComboExecution &execution)
+    {
+        if (comboGroupId == 0)
+            return;
+        auto [it, inserted] = mGroups.try_emplace(comboGroupId);
+        if (inserted)
+            mGroupOrder.push_back(comboGroupId);
+        ComboGroup &group = it->second;
+        if (mLegs.find(execution.orderBookId))
+        {
+            group.combinationOrderBookId = execution.orderBookId;
+            group.comboExecutions.push_back(execution);
+        }
+        else
+            group.legTrades.push_back(execution);
+    }
+
+    BookTable<std::vector<CombinationLeg>> mLegs;
+    std::unordered_map<Numeric4_t, ComboGroup> mGroups;
+    std::vector<Numeric4_t> mGroupOrder;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -50,7 +50,7 @@ namespace Midas::XSES::ITCH
         OrderExecuted = 'E',
         EndOfSnapshot = 'G',
         TickSize = 'L',
-        CombinationOrderBookDirectory = 'M',
+        CombinationOrderBookLeg = 'M',  // one message per leg of a combination Order Book
         OrderBookState = 'O',
         TradeMessageIdentifier = 'P',
         OrderBookDirectory = 'R',
@@ -0,0 +1,355 @@
+#pragma once
+#include <pcap.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "itch_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+#include "file_io.h"
+#include "arena.h"
+#include "book_table.h"
+#include "order_book.h"
+
+/** complete decoder state and its checkpoints
+ * state = sequence trackers + reference data + order books + Seconds clock
+ * checkpoint = header + the state as flat arrays, taken between two packets so decoding resumes at the next one
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+#define CHECKPOINT_MAGIC "XSESCKP1"
+
+#pragma pack(push, 1)
+
+struct SessionSequence
+{
+    Alpha_t<SESSION_LENGTH> session;
+    uint64_t nextSequenceNumber;
+    uint64_t gaps;
+    uint64_t missingMessages;
+};
+
+struct CheckpointHeader
+{
+    char magic[8];
+    uint64_t captureSize;  // guards against resuming another capture
+    /** where decoding resumes: the record, and the session and sequence number it must carry */
+    uint64_t recordOffset;
+    Alpha_t<SESSION_LENGTH> session;
+    uint64_t sequenceNumber;
+    Numeric4_t second;
+    uint64_t sessionCount;
+    uint64_t directoryCount;
+    uint64_t tickSizeCount;
+    uint64_t legCount;
+    uint64_t stateCount;
+    uint64_t orderCount;
+};
+
+struct CheckpointBookState
+{
+    Numeric4_t orderBookId;
+    Alpha_t<20> stateName;
+};
+
+struct CheckpointOrder
+{
+    OrderKey key;
+    LiveOrder order;
+};
+
+#pragma pack(pop)
+
+/**
+ * next expected sequence number per session, gaps seen so far
+ */
+class SequenceTracker
+{
+public:
+    void on_packet(const MoldUDP64Header &moldudp64_hdr)
+    {
+        const uint64_t seqNum = moldudp64_hdr.get_sequence_number();
+        std::size_t msgCnt = moldudp64_hdr.get_message_count();
+        if (msgCnt == 0xFFFF)
+            msgCnt = 0;
+        SessionSequence *sequence = find(moldudp64_hdr.session);
+        if (!sequence)
+        {
+            mSessions.push_back(SessionSequence{moldudp64_hdr.session, seqNum + msgCnt, 0, 0});
+            return;
+        }
+        if (seqNum > sequence->nextSequenceNumber)
+        {
+            ++sequence->gaps;
+            sequence->missingMessages += seqNum - sequence->nextSequenceNumber;
+        }
+        if (seqNum + msgCnt > sequence->nextSequenceNumber)
+            sequence->nextSequenceNumber = seqNum + msgCnt;
+    }
+
+    SessionSequence *find(const Alpha_t<SESSION_LENGTH> &session) noexcept
+    {
+        /** a handful of sessions a day, linear search is fine */
+        for (SessionSequence &sequence : mSessions)
+        {
+            if (sequence.session == session)
+                return &sequence;
+        }
+        return nullptr;
+    }
+
+    std::vector<SessionSequence> &get_sessions() noexcept
+    {
+        return mSessions;
+    }
+
+private:
+    std::vector<SessionSequence> mSessions;
+};
+
+/**
+ * 3.3.3 Reference Data Messages, kept as received
+ */
+struct ReferenceData
+{
+    BookTable<OrderBookDirectory> directories;
+    std::vector<TickSizeTableEntry, ArenaAllocator<TickSizeTableEntry>> tickSizes;
+    std::vector<CombinationOrderBookLeg, ArenaAllocator<CombinationOrderBookLeg>> legs;
+
+    void on_message(const MessageInfo *msgInfo)
+    {
+        switch (msgInfo->get_message_type())
+        {
+        case MessageType::OrderBookDirectory:
+        {
+            const OrderBookDirectory *feed = static_cast<const OrderBookDirectory *>(msgInfo);
+            directories[big_endian_to_host(feed->mOrderBookId)] = *feed;
+            break;
+        }
+        case MessageType::TickSize:
+            tickSizes.push_back(*static_cast<const TickSizeTableEntry *>(msgInfo));
+            break;
+        case MessageType::CombinationOrderBookLeg:
+            legs.push_back(*static_cast<const CombinationOrderBookLeg *>(msgInfo));
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+class DecoderState
+{
+public:
+    /**
+     * apply a MoldUDP64 packet, heartbeats and end of session included
+    */
+    void on_packet(const u_char *packet, std::size_t caplen, const MoldUDP64Header &moldudp64_hdr)
+    {
+        mSequences.on_packet(moldudp64_hdr);
+        for_each_message_block(packet, caplen, moldudp64_hdr,
+            [this](std::size_t, const MessageBlock *msgBlk)
+            {
+                on_message(reinterpret_cast<const MessageInfo *>(msgBlk->messageData));
+            });
+    }
+
+    void on_message(const MessageInfo *msgInfo)
+    {
+        switch (msgInfo->get_message_type())
+        {
+        case MessageType::Seconds:
+            mSecond = big_endian_to_host(static_cast<const Seconds *>(msgInfo)->second);
+            break;
+        case MessageType::OrderBookDirectory:
+        case MessageType::TickSize:
+        case MessageType::CombinationOrderBookLeg:
+            mReference.on_message(msgInfo);
+            break;
+        default:
+            mBooks.on_message(msgInfo);
+            break;
+        }
+    }
+
+    /**
+     * @param recordOffset the record decoding resumes at, right after the packet last applied
+     * @param moldudp64_hdr the packet last applied, its session and next sequence number tag the checkpoint
+    */
+    bool save(const char *path, const PcapFile &input, std::size_t recordOffset,
+        const MoldUDP64Header &moldudp64_hdr, std::string &error)
+    {
+        CheckpointHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.captureSize = input.size();
+        header.recordOffset = recordOffset;
+        header.session = moldudp64_hdr.session;
+        const SessionSequence *sequence = mSequences.find(moldudp64_hdr.session);
+        header.sequenceNumber = sequence ? sequence->nextSequenceNumber : 0;
+        header.second = mSecond;
+        header.sessionCount = mSequences.get_sessions().size();
+        mReference.directories.for_each([&header](Numeric4_t, const OrderBookDirectory &) { ++header.directoryCount; });
+        header.tickSizeCount = mReference.tickSizes.size();
+        header.legCount = mReference.legs.size();
+        mBooks.for_each_state([&header](Numeric4_t, const Alpha_t<20> &) { ++header.stateCount; });
+        header.orderCount = mBooks.get_order_count();
+
+        FileWriter output;
+        if (!output.open(path, error))
+            return false;
+        bool ok = output.write_pod(header)
+            && output.write(mSequences.get_sessions().data(), header.sessionCount * sizeof(SessionSequence));
+        mReference.directories.for_each([&](Numeric4_t, const OrderBookDirectory &directory)
+        {
+            ok = ok && output.write_pod(directory);
+        });
+        ok = ok && output.write(mReference.tickSizes.data(), header.tickSizeCount * sizeof(TickSizeTableEntry))
+            && output.write(mReference.legs.data(), header.legCount * sizeof(CombinationOrderBookLeg));
+        mBooks.for_each_state([&](Numeric4_t orderBookId, const Alpha_t<20> &stateName)
+        {
+            ok = ok && output.write_pod(CheckpointBookState{orderBookId, stateName});
+        });
+        mBooks.for_each_order([&](const OrderKey &key, const LiveOrder &order)
+        {
+            ok = ok && output.write_pod(CheckpointOrder{key, order});
+        });
+        ok = ok && output.close();
+        if (!ok)
+            error = std::string(path) + ": " + std::strerror(errno);
+        return ok;
+    }
+
+    /**
+     * replace the whole state with the checkpoint and position input at the packet to resume with
+    */
+    bool load(const char *path, PcapFile &input, std::string &error)
+    {
+        MappedFile file;
+        if (!file.open(path, error))
+            return false;
+        const u_char *cursor = file.data();
+        const u_char *end = file.data() + file.size();
+        auto take = [&cursor, end](std::size_t len) -> const u_char *
+        {
+            if (static_cast<std::size_t>(end - cursor) < len)
+                return nullptr;
+            const u_char *ptr = cursor;
+            cursor += len;
+            return ptr;
+        };
+
+        const CheckpointHeader *header = reinterpret_cast<const CheckpointHeader *>(take(sizeof(CheckpointHeader)));
+        if (!header || std::memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0)
+        {
+            error = std::string(path) + ": not a checkpoint";
+            return false;
+        }
+        if (header->captureSize != input.size())
+        {
+            error = std::string(path) + ": taken on another capture";
+            return false;
+        }
+        const u_char *sessions = take(header->sessionCount * sizeof(SessionSequence));
+        const u_char *directories = take(header->directoryCount * sizeof(OrderBookDirectory));
+        const u_char *tickSizes = take(header->tickSizeCount * sizeof(TickSizeTableEntry));
+        const u_char *legs = take(header->legCount * sizeof(CombinationOrderBookLeg));
+        const u_char *states = take(header->stateCount * sizeof(CheckpointBookState));
+        const u_char *orders = take(header->orderCount * sizeof(CheckpointOrder));
+        if (!orders || cursor != end)
+        {
+            error = std::string(path) + ": truncated checkpoint";
+            return false;
+        }
+
+        *this = DecoderState();
+        mSecond = header->second;
+        const SessionSequence *sessionBegin = reinterpret_cast<const SessionSequence *>(sessions);
+        mSequences.get_sessions().assign(sessionBegin, sessionBegin + header->sessionCount);
+        for (std::size_t i = 0; i < header->directoryCount; ++i)
+            mReference.on_message(reinterpret_cast<const OrderBookDirectory *>(directories) + i);
+        const TickSizeTableEntry *tickSizeBegin = reinterpret_cast<const TickSizeTableEntry *>(tickSizes);
+        mReference.tickSizes.assign(tickSizeBegin, tickSizeBegin + header->tickSizeCount);
+        const CombinationOrderBookLeg *legBegin = reinterpret_cast<const CombinationOrderBookLeg *>(legs);
+        mReference.legs.assign(legBegin, legBegin + header->legCount);
+        for (std::size_t i = 0; i < header->stateCount; ++i)
+        {
+            const CheckpointBookState &state = reinterpret_cast<const CheckpointBookState *>(states)[i];
+            mBooks.set_state(state.orderBookId, state.stateName);
+        }
+        for (std::size_t i = 0; i < header->orderCount; ++i)
+        {
+            const CheckpointOrder &order = reinterpret_cast<const CheckpointOrder *>(orders)[i];
+            mBooks.insert(order.key, order.order);
+        }
+
+        if (!seek_resume_packet(input, *header))
+        {
+            error = std::string(path) + ": resume packet not found in capture";
+            return false;
+        }
+        return true;
+    }
+
+    Numeric4_t get_second() const noexcept
+    {
+        return mSecond;
+    }
+
+    SequenceTracker &get_sequences() noexcept
+    {
+        return mSequences;
+    }
+
+    ReferenceData &get_reference_data() noexcept
+    {
+        return mReference;
+    }
+
+    OrderBooks &get_order_books() noexcept
+    {
+        return mBooks;
+    }
+
+private:
+    /**
+     * the recorded offset is checked against the recorded session and sequence number,
+     * on mismatch the capture is scanned for the first packet at or past that sequence number
+    */
+    static bool seek_resume_packet(PcapFile &input, const CheckpointHeader &header)
+    {
+        PcapRecord record;
+        if (input.seek(header.recordOffset))
+        {
+            if (!input.next(record))
+                return true;  // checkpoint taken on the last packet
+            const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(record.packet, record.hdr->capLen);
+            if (!moldudp64_hdr || (moldudp64_hdr->session == header.session
+                && moldudp64_hdr->get_sequence_number() == header.sequenceNumber))
+                return input.seek(header.recordOffset);
+        }
+        input.rewind();
+        while (input.next(record))
+        {
+            const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(record.packet, record.hdr->capLen);
+            if (moldudp64_hdr && moldudp64_hdr->session == header.session
+                && moldudp64_hdr->get_sequence_number() >= header.sequenceNumber)
+                return input.seek(record.offset);
+        }
+        return false;
+    }
+
+    SequenceTracker mSequences;
+    ReferenceData mReference;
+    OrderBooks mBooks;
+    Numeric4_t mSecond = 0;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,188 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+
+/** file access shared by captures, index files and checkpoints
+ * input is mapped read only, output leaves in large sequential write(2) calls from a buffer in the thread's arena
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile()
+    {
+        close();
+    }
+
+    bool open(const char *path, std::string &error)
+    {
+        close();
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            error = std::string(path) + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            error = std::string(path) + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        if (st.st_size == 0)
+        {
+            ::close(fd);
+            return true;
+        }
+        void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            error = std::string(path) + ": mmap: " + std::strerror(errno);
+            return false;
+        }
+        mData = static_cast<const unsigned char *>(addr);
+        mSize = st.st_size;
+        return true;
+    }
+
+    void close() noexcept
+    {
+        if (mData)
+            ::munmap(const_cast<unsigned char *>(mData), mSize);
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    /**
+     * @param advice MADV_SEQUENTIAL for one pass readers, MADV_RANDOM for lookups
+    */
+    void advise(int advice) const noexcept
+    {
+        if (mData)
+            ::madvise(const_cast<unsigned char *>(mData), mSize, advice);
+    }
+
+    const unsigned char *data() const noexcept
+    {
+        return mData;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+private:
+    const unsigned char *mData = nullptr;
+    std::size_t mSize = 0;
+};
+
+class FileWriter
+{
+public:
+    static constexpr std::size_t BUFFER_SIZE = 4 << 20;
+
+    FileWriter() = default;
+    FileWriter(const FileWriter &) = delete;
+    FileWriter &operator=(const FileWriter &) = delete;
+    ~FileWriter()
+    {
+        close();
+    }
+
+    bool open(const char *path, std::string &error)
+    {
+        close();
+        mFd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (mFd < 0)
+        {
+            error = std::string(path) + ": " + std::strerror(errno);
+            return false;
+        }
+        mBuffer.resize(BUFFER_SIZE);
+        mUsed = 0;
+        return true;
+    }
+
+    /**
+     * small writes are gathered in the buffer, large ones bypass it
+    */
+    bool write(const void *data, std::size_t len)
+    {
+        if (mUsed + len > mBuffer.size())
+        {
+            if (!flush())
+                return false;
+            if (len >= mBuffer.size())
+                return write_fully(data, len);
+        }
+        std::memcpy(mBuffer.data() + mUsed, data, len);
+        mUsed += len;
+        return true;
+    }
+
+    template <typename T>
+    bool write_pod(const T &value)
+    {
+        return write(&value, sizeof(value));
+    }
+
+    bool flush()
+    {
+        const bool ok = write_fully(mBuffer.data(), mUsed);
+        mUsed = 0;
+        return ok;
+    }
+
+    bool close()
+    {
+        if (mFd < 0)
+            return true;
+        const bool ok = flush();
+        ::close(mFd);
+        mFd = -1;
+        return ok;
+    }
+
+private:
+    bool write_fully(const void *data, std::size_t len)
+    {
+        const char *ptr = static_cast<const char *>(data);
+        while (len > 0)
+        {
+            const ssize_t written = ::write(mFd, ptr, len);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            ptr += written;
+            len -= written;
+        }
+        return true;
+    }
+
+    int mFd = -1;
+    std::vector<char, ArenaAllocator<char>> mBuffer;
+    std::size_t mUsed = 0;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,132 @@
+#pragma once
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+/** minimal C++20 generator, a lazy input range fed by co_yield
+ * yielded values are referenced, never copied, they live in the suspended coroutine frame
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+template <typename T>
+class Generator
+{
+public:
+    struct promise_type
+    {
+        const T *mValue = nullptr;
+        std::exception_ptr mException;
+
+        Generator get_return_object() noexcept
+        {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        std::suspend_always final_suspend() const noexcept
+        {
+            return {};
+        }
+        std::suspend_always yield_value(const T &value) noexcept
+        {
+            mValue = std::addressof(value);
+            return {};
+        }
+        void return_void() const noexcept
+        {
+        }
+        void unhandled_exception() noexcept
+        {
+            mException = std::current_exception();
+        }
+        template <typename U>
+        void await_transform(U &&) = delete;  // generators do not co_await
+    };
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using reference = const T &;
+        using pointer = const T *;
+
+        iterator() noexcept = default;
+        explicit iterator(std::coroutine_handle<promise_type> coroutine) noexcept
+            : mCoroutine(coroutine)
+        {
+        }
+        reference operator*() const noexcept
+        {
+            return *mCoroutine.promise().mValue;
+        }
+        pointer operator->() const noexcept
+        {
+            return mCoroutine.promise().mValue;
+        }
+        iterator &operator++()
+        {
+            resume(mCoroutine);
+            return *this;
+        }
+        void operator++(int)
+        {
+            ++*this;
+        }
+        bool operator==(std::default_sentinel_t) const noexcept
+        {
+            return !mCoroutine || mCoroutine.done();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> mCoroutine;
+    };
+
+    Generator(Generator &&other) noexcept
+        : mCoroutine(std::exchange(other.mCoroutine, {}))
+    {
+    }
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator()
+    {
+        if (mCoroutine)
+            mCoroutine.destroy();
+    }
+
+    iterator begin()
+    {
+        resume(mCoroutine);
+        return iterator(mCoroutine);
+    }
+    std::default_sentinel_t end() const noexcept
+    {
+        return {};
+    }
+
+private:
+    explicit Generator(std::coroutine_handle<promise_type> coroutine) noexcept
+        : mCoroutine(coroutine)
+    {
+    }
+
+    static void resume(std::coroutine_handle<promise_type> coroutine)
+    {
+        coroutine.resume();
+        if (coroutine.promise().mException)
+            std::rethrow_exception(coroutine.promise().mException);
+    }
+
+    std::coroutine_handle<promise_type> mCoroutine;
+};
+
+} // namespace Midas::XSES::ITCH
+#endif
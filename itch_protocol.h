@@ -114,7 +114,7 @@ namespace Midas::XSES::ITCH
                 alpha_to_string(mSymbol).c_str(),
                 alpha_to_string(mLongName).c_str(),
                 alpha_to_string(mIsin).c_str(),
-                mFinancialProduct,
+                static_cast<unsigned>(mFinancialProduct),
                 alpha_to_string(mTradingCurrency).c_str(),
                 big_endian_to_host(mNumberOfDecimalsInPrice),
                 big_endian_to_host(mNumberOfDecimalsInNominalValue),
@@ -127,7 +127,7 @@ namespace Midas::XSES::ITCH
                 big_endian_to_host(mStrikePrice),
                 big_endian_to_host(mExpirationDate),
                 big_endian_to_host(mNumberOfDecimalsInStrikePrice),
-                mPutOrCall
+                static_cast<unsigned>(mPutOrCall)
             );
             return buffer;
         }
@@ -507,6 +507,51 @@ namespace Midas::XSES::ITCH
         }
     };
 
+    /**
+     * Order Book ID carried by a message, if any
+     * @return false for messages not bound to an Order Book (Seconds, SystemEvent)
+     * @note for CombinationOrderBookLeg this is the combination Order Book ID
+    */
+    inline bool get_order_book_id(const MessageInfo *msgInfo, Numeric4_t &orderBookId) noexcept
+    {
+        switch (msgInfo->get_message_type())
+        {
+        case MessageType::OrderBookDirectory:
+            orderBookId = big_endian_to_host(static_cast<const OrderBookDirectory *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::CombinationOrderBookLeg:
+            orderBookId = big_endian_to_host(static_cast<const CombinationOrderBookLeg *>(msgInfo)->mCombinationOrderBookId);
+            return true;
+        case MessageType::TickSize:
+            orderBookId = big_endian_to_host(static_cast<const TickSizeTableEntry *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::OrderBookState:
+            orderBookId = big_endian_to_host(static_cast<const OrderBookState *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::AddOrder:
+            orderBookId = big_endian_to_host(static_cast<const AddOrder *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::OrderExecuted:
+        case MessageType::OrderExecutedWithPrice:
+            orderBookId = big_endian_to_host(static_cast<const OrderExecuted *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::OrderReplace:
+            orderBookId = big_endian_to_host(static_cast<const OrderReplace *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::OrderDelete:
+            orderBookId = big_endian_to_host(static_cast<const OrderDelete *>(msgInfo)->orderBookId);
+            return true;
+        case MessageType::TradeMessageIdentifier:
+            orderBookId = big_endian_to_host(static_cast<const Trade *>(msgInfo)->mOrderBookId);
+            return true;
+        case MessageType::EquilibriumPriceUpdate:
+            orderBookId = big_endian_to_host(static_cast<const EquilibriumPriceUpdate *>(msgInfo)->mOrderBookId);
+            return true;
+        default:
+            return false;
+        }
+    }
+
 
 #pragma pack(pop)
 } // namespace Midas::XSES::ITCH
\ No newline at end of file
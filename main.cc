@@ -1,4 +1,6 @@
 #include <string>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <pcap.h>
 #include <linux/if_ether.h>
@@ -8,6 +10,18 @@
 #include "utils.h"
 #include "moldudp64_protocol.h"
 #include "itch_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+#include "pcap_slicer.h"
+#include "pcap_replay.h"
+#include "order_store.h"
+#include "auction_tracker.h"
+#include "combination_registry.h"
+#include "decoder_state.h"
+#include "message_view.h"
+#include "message_statistics.h"
+#include "capture_diff.h"
+#include "synthetic_feed.h"
 
 /**
  * message: an atomic unit of info
@@ -19,62 +33,6 @@
 
 using namespace Midas::XSES::ITCH;
 
-bool eth_header_check(const u_char *&packet, const ethhdr *&eth_hdr)
-{
-    /**
-     * Data Link, Ethernet: frame = frame header + frame data
-     * */
-    // viewdone: how do we know we should compare ip_hdr->protocal with IPPROTO_UDP, compare eth_hdr->h_proto with ETH_P_IP
-    eth_hdr = reinterpret_cast<const ethhdr *>(packet);
-    // viewdone: ETH_P_IP is defined as 2 byte, but stored as 4 byte, how to specify its data type??? -> static_cast<uint16_t>
-    if (big_endian_to_host(eth_hdr->h_proto) != static_cast<uint16_t>(ETH_P_IP))
-        return false;
-    return true;
-}
-
-bool ip_header_check(const ethhdr *&eth_hdr, const iphdr *&ip_hdr)
-{
-    /**
-     * Network, Ip: packet = frame data = packet header + packet data
-     * this packet != packet variable, packet variable is frame
-     * */
-    // viewdone: why eth_hdr+1? -> ptr+1 means ptr+sizeof(type being pointed), so here +1 means +sizeof(eth_hdr)
-    // viewtodo: reinterpret_cast vs static_cast vs dynamic_cast vs const_cast
-    ip_hdr = reinterpret_cast<const iphdr *>(eth_hdr + 1);
-    if (static_cast<unsigned int>(ip_hdr->protocol) != IPPROTO_UDP)
-        return false;
-    return true;
-}
-
-bool moldudp64_header_check(const u_char *&packet, const Midas::XSES::ITCH::MoldUDP64Header *&moldudp64_hdr)
-{
-    /**
-     * transport, MoldUDP64 message=downstreampacket:
-     * downstreampacket = packet data = downstreampacket header + downstreampacket data
-     * message != message block, message block is in ITCH, message (downstream packet) is in MoldUDP64
-     * */
-    moldudp64_hdr = reinterpret_cast<const Midas::XSES::ITCH::MoldUDP64Header *>(packet + UDP_HEADER_LENGTH);
-    const Numeric2_t msgCnt = moldudp64_hdr->get_message_count();
-    if (msgCnt == 0)
-    {
-        // std::cout<<"heartbeat, next expected sequence number: "<<seqNum<<std::endl;
-        // printf("heartbeat, next expected sequence number: %016x\n", seqNum);
-        return false;
-    }
-    if (msgCnt == 0xFFFF)
-    {
-        /**
-         * While the End of Session messages persist,
-         * re-requests may be made on the current session.
-         * This is the last chance to ensure that all messages have been received
-         */
-        // std::cout<<"end of session, next expected sequence number: "<<seqNum<<std::endl;
-        // printf("end of session, next expected sequence number: %016x\n", seqNum);
-        return false;
-    }
-    return true;
-}
-
 std::string decode(const Midas::XSES::ITCH::MessageInfo *msgInfo)
 {
     // printf("message data one by one:\n");
@@ -96,7 +54,7 @@ std::string decode(const Midas::XSES::ITCH::MessageInfo *msgInfo)
         const Midas::XSES::ITCH::OrderBookDirectory *feed = reinterpret_cast<const Midas::XSES::ITCH::OrderBookDirectory *>(msgInfo);
         return feed->to_string();
     }
-    case Midas::XSES::ITCH::MessageType::CombinationOrderBookDirectory:
+    case Midas::XSES::ITCH::MessageType::CombinationOrderBookLeg:
     {
         const Midas::XSES::ITCH::CombinationOrderBookLeg *feed = reinterpret_cast<const Midas::XSES::ITCH::CombinationOrderBookLeg *>(msgInfo);
         return feed->to_string();
@@ -187,7 +145,7 @@ void decode_and_handle_itch_message_blocks(const u_char *&packet, const Midas::X
     }
 }
 
-void callback(u_char *additional_args, const struct pcap_pkthdr *hdr, const u_char *packet)
+void callback(u_char * /* additional_args */, const struct pcap_pkthdr * /* hdr */, const u_char *packet)
 {
     // std::cout << "\na callback called" << std::endl;
     const ethhdr *eth_hdr = nullptr;
@@ -204,8 +162,668 @@ void callback(u_char *additional_args, const struct pcap_pkthdr *hdr, const u_ch
     decode_and_handle_itch_message_blocks(packet, moldudp64_hdr);
 }
 
+bool parse_session(const char *arg, Alpha_t<SESSION_LENGTH> &session)
+{
+    const std::size_t len = std::strlen(arg);
+    if (len > SESSION_LENGTH)
+        return false;
+    session.fill(' ');
+    std::memcpy(session.data(), arg, len);
+    return true;
+}
+
+int run_slice(int argc, char const *argv[])
+{
+    /**
+     * slice <in.pcap> <out.pcap> [--session NAME] [--seq FIRST-LAST] [--book ID[,ID...]]
+     * */
+    if (argc < 3)
+    {
+        std::cerr << "usage: slice <in.pcap> <out.pcap> [--session NAME] [--seq FIRST-LAST] [--book ID[,ID...]]" << std::endl;
+        return 1;
+    }
+    SliceFilter filter;
+    if ((argc - 3) % 2 != 0)
+    {
+        std::cerr << "missing value for option: " << argv[argc - 1] << std::endl;
+        return 1;
+    }
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        const std::string opt = argv[i];
+        const char *value = argv[i + 1];
+        if (opt == "--session")
+        {
+            filter.hasSession = parse_session(value, filter.session);
+            if (!filter.hasSession)
+            {
+                std::cerr << "session longer than " << SESSION_LENGTH << " characters: " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (opt == "--seq")
+        {
+            char *end = nullptr;
+            filter.firstSequenceNumber = std::strtoull(value, &end, 10);
+            if (*end == '-' && *(end + 1) != '\0')
+                filter.lastSequenceNumber = std::strtoull(end + 1, nullptr, 10);
+        }
+        else if (opt == "--book")
+        {
+            for (const char *next = value; *next != '\0';)
+            {
+                char *end = nullptr;
+                const unsigned long orderBookId = std::strtoul(next, &end, 10);
+                if (end == next || (*end != ',' && *end != '\0'))
+                {
+                    std::cerr << "invalid Order Book ID list: " << value << std::endl;
+                    return 1;
+                }
+                filter.orderBookIds.insert(orderBookId);
+                next = *end == ',' ? end + 1 : end;
+            }
+        }
+        else
+        {
+            std::cerr << "unknown option: " << opt << std::endl;
+            return 1;
+        }
+    }
+
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    PcapWriter output;
+    if (!output.open(argv[2], input.get_global_header(), error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    PcapSlicer slicer(filter);
+    if (!slicer.run(input, output) || !output.close())
+    {
+        std::cerr << argv[2] << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    const SliceStatistics &stats = slicer.get_statistics();
+    std::cerr << "frames read: " << stats.framesRead
+              << ", copied: " << stats.framesCopied
+              << ", repacked: " << stats.framesRepacked << " into " << stats.repackedPacketsWritten
+              << ", dropped: " << stats.framesDropped
+              << ", messages kept: " << stats.messagesKept
+              << ", messages dropped: " << stats.messagesDropped << std::endl;
+    return 0;
+}
+
+int run_replay(int argc, char const *argv[])
+{
+    /**
+     * replay <in.pcap> <host> <port> [--speed X] [--max] [--batch N]
+     * */
+    if (argc < 4)
+    {
+        std::cerr << "usage: replay <in.pcap> <host> <port> [--speed X] [--max] [--batch N]" << std::endl;
+        return 1;
+    }
+    ReplayOptions options;
+    for (int i = 4; i < argc; ++i)
+    {
+        const std::string opt = argv[i];
+        if (opt == "--max")
+            options.maxRate = true;
+        else if (opt == "--speed" && i + 1 < argc)
+            options.speed = std::strtod(argv[++i], nullptr);
+        else if (opt == "--batch" && i + 1 < argc)
+            options.batchSize = std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            std::cerr << "unknown option: " << opt << std::endl;
+            return 1;
+        }
+    }
+    if (!options.maxRate && options.speed <= 0)
+    {
+        std::cerr << "speed must be positive" << std::endl;
+        return 1;
+    }
+
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    PcapReplayer replayer;
+    if (!replayer.open(argv[2], static_cast<uint16_t>(std::atoi(argv[3])), error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (!replayer.run(input, options))
+    {
+        std::cerr << "sendmmsg: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    const ReplayStatistics &stats = replayer.get_statistics();
+    std::printf("packets: %lu, messages: %lu, bytes: %lu, sendmmsg calls: %lu, truncated frames skipped: %lu\n",
+        stats.packets, stats.messages, stats.bytes, stats.sendCalls, stats.truncatedFrames);
+    std::printf("elapsed: %.6f s, capture span: %.6f s, achieved speed: %.2fx\n",
+        stats.elapsedNs / 1e9, stats.captureSpanNs / 1e9, stats.get_achieved_speed());
+    std::printf("rate: %.0f packets/s, %.0f messages/s, %.1f Mbit/s\n",
+        stats.get_packet_rate(), stats.get_message_rate(), stats.get_megabits_per_second());
+    if (!options.maxRate)
+        std::printf("timing error: mean %.0f ns, max %lu ns\n",
+            stats.get_mean_lateness_ns(), stats.maxLatenessNs);
+    return 0;
+}
+
+int run_index(int argc, char const *argv[])
+{
+    /**
+     * index <in.pcap> <out.idx>
+     * */
+    if (argc < 3)
+    {
+        std::cerr << "usage: index <in.pcap> <out.idx>" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    OrderStoreBuilder builder;
+    builder.build(input);
+    if (!builder.write(argv[2], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cerr << "orders: " << builder.get_order_count()
+              << ", events: " << builder.get_event_count()
+              << ", arena bytes: " << builder.get_arena().get_bytes_allocated() << std::endl;
+    return 0;
+}
+
+int run_query(int argc, char const *argv[])
+{
+    /**
+     * query <in.pcap> <in.idx> <orderBookId> <side> <orderId>
+     * orderId in hex, as printed by AddOrder/OrderExecuted/OrderDelete
+     * */
+    if (argc < 6)
+    {
+        std::cerr << "usage: query <in.pcap> <in.idx> <orderBookId> <side> <orderId>" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    OrderStore store;
+    if (!input.open(argv[1], error) || !store.open(argv[2], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (store.get_header().captureSize != input.size())
+    {
+        std::cerr << argv[2] << ": built from another capture" << std::endl;
+        return 1;
+    }
+    const Numeric4_t orderBookId = std::strtoul(argv[3], nullptr, 10);
+    const char side = argv[4][0];
+    const Numeric8_t orderId = std::strtoull(argv[5], nullptr, 16);
+
+    const uint64_t startNs = monotonic_now_ns();
+    std::size_t eventCount = 0;
+    const OrderEvent *events = store.find(orderBookId, side, orderId, eventCount);
+    const uint64_t lookupNs = monotonic_now_ns() - startNs;
+    if (!events)
+    {
+        std::cerr << "order not found" << std::endl;
+        return 1;
+    }
+    for (std::size_t i = 0; i < eventCount; ++i)
+    {
+        const u_char *packet = input.data() + events[i].recordOffset + sizeof(PcapRecordHeader);
+        const MoldUDP64Header *moldudp64_hdr = reinterpret_cast<const MoldUDP64Header *>(packet + UDP_HEADER_LENGTH);
+        const MessageBlock *msgBlk = reinterpret_cast<const MessageBlock *>(packet + events[i].blockOffset);
+        std::cout
+            << alpha_to_string(moldudp64_hdr->get_session()) << ","
+            << moldudp64_hdr->get_sequence_number() + events[i].messageIndex << ","
+            << decode(reinterpret_cast<const MessageInfo *>(msgBlk->messageData))
+            << std::endl;
+    }
+    std::cerr << "events: " << eventCount << ", lookup: " << lookupNs << " ns" << std::endl;
+    return 0;
+}
+
+int run_auction(int argc, char const *argv[])
+{
+    /**
+     * auction <in.pcap>
+     * */
+    if (argc < 2)
+    {
+        std::cerr << "usage: auction <in.pcap>" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    AuctionTracker tracker(std::cout);
+    MessageReader reader(input);
+    MessageView views[256];
+    while (const std::size_t count = reader.next_batch(views, 256))
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            tracker.on_message(views[i].get_message_info());
+    }
+    tracker.finish();
+    std::cout.flush();
+    std::cerr << "state changes: " << tracker.get_summary_count() << std::endl;
+    return 0;
+}
+
+int run_combos(int argc, char const *argv[])
+{
+    /**
+     * combos <in.pcap>
+     * one line per ComboGroupId:
+     * group, combination book, combination quantity, combination price, implied price, legs (book:side:ratio:price:quantity;...)
+     * */
+    if (argc < 2)
+    {
+        std::cerr << "usage: combos <in.pcap>" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    CombinationRegistry registry;
+    MessageReader reader(input);
+    MessageView views[256];
+    while (const std::size_t count = reader.next_batch(views, 256))
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            registry.on_message(views[i].get_message_info());
+    }
+
+    registry.for_each_group([&registry](Numeric4_t comboGroupId, const ComboGroup &group)
+    {
+        char buffer[MAX_LEN_PER_MESSAGE];
+        double comboPrice = 0;
+        Numeric8_t comboQuantity = 0;
+        const bool hasComboPrice = CombinationRegistry::get_average_price(
+            group.comboExecutions, group.combinationOrderBookId, comboPrice, comboQuantity);
+        double impliedPrice = 0;
+        const bool hasImpliedPrice = registry.get_implied_price(group, impliedPrice);
+        std::snprintf(buffer, sizeof(buffer), "%u,%u,%lu,%s,%s,",
+            comboGroupId,
+            group.combinationOrderBookId,
+            comboQuantity,
+            hasComboPrice ? std::to_string(comboPrice).c_str() : "",
+            hasImpliedPrice ? std::to_string(impliedPrice).c_str() : "");
+        std::string line = buffer;
+        const std::vector<CombinationLeg> *legs = registry.find_legs(group.combinationOrderBookId);
+        for (std::size_t i = 0; legs && i < legs->size(); ++i)
+        {
+            const CombinationLeg &leg = (*legs)[i];
+            double legPrice = 0;
+            Numeric8_t legQuantity = 0;
+            const bool hasLegPrice = CombinationRegistry::get_average_price(
+                group.legTrades, leg.legOrderBookId, legPrice, legQuantity);
+            std::snprintf(buffer, sizeof(buffer), "%s%u:%c:%u:%s:%lu",
+                i ? ";" : "",
+                leg.legOrderBookId,
+                leg.legSide,
+                leg.legRatio,
+                hasLegPrice ? std::to_string(legPrice).c_str() : "",
+                legQuantity);
+            line += buffer;
+        }
+        std::cout << line << '\n';
+    });
+    std::cout.flush();
+    return 0;
+}
+
+/**
+ * second, live orders and next sequence number per session, compared between checkpoint and resume runs
+*/
+std::string describe_decoder_state(DecoderState &state)
+{
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "second %u, orders %lu, next sequence number",
+        state.get_second(), static_cast<uint64_t>(state.get_order_books().get_order_count()));
+    std::string description = buffer;
+    for (const SessionSequence &sequence : state.get_sequences().get_sessions())
+    {
+        std::snprintf(buffer, sizeof(buffer), " %s:%lu",
+            alpha_to_string(sequence.session).c_str(), sequence.nextSequenceNumber);
+        description += buffer;
+    }
+    return description;
+}
+
+int run_checkpoint(int argc, char const *argv[])
+{
+    /**
+     * checkpoint <in.pcap> <prefix> [--every SECONDS]
+     * writes <prefix>.<sequence number>.ckp whenever the Seconds clock passes a multiple of SECONDS
+     * */
+    if (argc < 3)
+    {
+        std::cerr << "usage: checkpoint <in.pcap> <prefix> [--every SECONDS]" << std::endl;
+        return 1;
+    }
+    Numeric4_t every = 60;
+    if (argc > 4 && std::strcmp(argv[3], "--every") == 0)
+        every = std::strtoul(argv[4], nullptr, 10);
+    if (every == 0)
+    {
+        std::cerr << "--every must be positive" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    DecoderState state;
+    Numeric4_t lastPeriod = 0;
+    PcapRecord record;
+    while (input.next(record))
+    {
+        const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(record.packet, record.hdr->capLen);
+        if (!moldudp64_hdr)
+            continue;
+        state.on_packet(record.packet, record.hdr->capLen, *moldudp64_hdr);
+        const Numeric4_t period = state.get_second() / every;
+        if (period == lastPeriod)
+            continue;
+        lastPeriod = period;
+        const SessionSequence *sequence = state.get_sequences().find(moldudp64_hdr->session);
+        const std::string path = std::string(argv[2]) + "." + std::to_string(sequence->nextSequenceNumber) + ".ckp";
+        if (!state.save(path.c_str(), input, record.offset + record.get_size(), *moldudp64_hdr, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::cerr << path << ": " << describe_decoder_state(state) << std::endl;
+    }
+    std::cerr << "end: " << describe_decoder_state(state) << std::endl;
+    return 0;
+}
+
+int run_resume(int argc, char const *argv[])
+{
+    /**
+     * resume <in.pcap> <checkpoint> [packets]
+     * restores the state and decodes from the packet after the checkpoint, as without a mode
+     * */
+    if (argc < 3)
+    {
+        std::cerr << "usage: resume <in.pcap> <checkpoint> [packets]" << std::endl;
+        return 1;
+    }
+    const long packets_to_read = argc > 3 ? std::atol(argv[3]) : -1;
+    std::string error;
+    PcapFile input;
+    DecoderState state;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    const uint64_t startNs = monotonic_now_ns();
+    if (!state.load(argv[2], input, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cerr << "restored in " << (monotonic_now_ns() - startNs) / 1000 << " us: " << describe_decoder_state(state) << std::endl;
+
+    PcapRecord record;
+    for (long count = 0; count != packets_to_read && input.next(record); ++count)
+    {
+        const u_char *packet = record.packet;
+        const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(packet, record.hdr->capLen);
+        if (!moldudp64_hdr)
+            continue;
+        state.on_packet(packet, record.hdr->capLen, *moldudp64_hdr);
+        if (moldudp64_header_check(packet, moldudp64_hdr))
+            decode_and_handle_itch_message_blocks(packet, moldudp64_hdr);
+    }
+    std::cerr << "end: " << describe_decoder_state(state) << std::endl;
+    return 0;
+}
+
+int run_stats(int argc, char const *argv[])
+{
+    /**
+     * stats <in.pcap>
+     * */
+    if (argc < 2)
+    {
+        std::cerr << "usage: stats <in.pcap>" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    MessageStatistics statistics;
+    PcapRecord record;
+    while (input.next(record))
+        statistics.on_packet(input, record);
+    statistics.report(stdout);
+    return 0;
+}
+
+int run_diff(int argc, char const *argv[])
+{
+    /**
+     * diff <a.pcap> <b.pcap> [--window MESSAGES]
+     * one line per difference, see capture_diff.h, totals on stderr
+     * exit status 0 when both captures carry the same messages
+     * */
+    if (argc < 3)
+    {
+        std::cerr << "usage: diff <a.pcap> <b.pcap> [--window MESSAGES]" << std::endl;
+        return 1;
+    }
+    std::size_t window = CaptureDiff::DEFAULT_WINDOW;
+    if (argc > 4 && std::strcmp(argv[3], "--window") == 0)
+        window = std::strtoul(argv[4], nullptr, 10);
+    if (window == 0)
+    {
+        std::cerr << "--window must be positive" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile first;
+    PcapFile second;
+    if (!first.open(argv[1], error) || !second.open(argv[2], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    CaptureDiff diff(std::cout, window);
+    diff.run(first, second);
+    std::cout.flush();
+
+    const DiffStatistics &statistics = diff.get_statistics();
+    const uint64_t compared = statistics.matched + statistics.mismatched;
+    std::cerr << "matched: " << statistics.matched << ", mismatched: " << statistics.mismatched
+              << ", missing: " << statistics.missing << ", extra: " << statistics.extra
+              << ", duplicates: " << statistics.duplicates << std::endl;
+    if (compared)
+        std::cerr << "capture time b - a (ns): min " << statistics.minDeltaNs << ", max " << statistics.maxDeltaNs
+                  << ", mean " << statistics.totalDeltaNs / static_cast<int64_t>(compared) << std::endl;
+    return statistics.mismatched || statistics.missing || statistics.extra ? 2 : 0;
+}
+
+int run_generate(int argc, char const *argv[])
+{
+    /**
+     * generate <out.pcap> [--messages N] [--seed S] [--books N]
+     * synthetic capture, see synthetic_feed.h
+     * */
+    if (argc < 2)
+    {
+        std::cerr << "usage: generate <out.pcap> [--messages N] [--seed S] [--books N]" << std::endl;
+        return 1;
+    }
+    SyntheticFeedOptions options;
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        const std::string opt = argv[i];
+        const uint64_t value = std::strtoull(argv[i + 1], nullptr, 10);
+        if (opt == "--messages")
+            options.messages = value;
+        else if (opt == "--seed")
+            options.seed = value;
+        else if (opt == "--books" && value > 0)
+            options.books = value;
+        else
+        {
+            std::cerr << "unknown option: " << opt << " " << argv[i + 1] << std::endl;
+            return 1;
+        }
+    }
+    std::string error;
+    SyntheticFeed feed(options);
+    if (!feed.write(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::cerr << "packets: " << feed.get_packet_count() << ", messages: " << feed.get_message_count() << std::endl;
+    return 0;
+}
+
+/**
+ * swallows the decoded lines of a benchmark run
+ */
+class NullBuffer: public std::streambuf
+{
+protected:
+    int overflow(int c) override
+    {
+        return c;
+    }
+    std::streamsize xsputn(const char *, std::streamsize n) override
+    {
+        return n;
+    }
+};
+
+int run_bench(int argc, char const *argv[])
+{
+    /**
+     * bench <in.pcap> [--iterations N]
+     * times the default decode path, decode_and_handle_itch_message_blocks with its output discarded
+     * best of N passes over the capture, as metric,value lines for perf-check
+     * */
+    if (argc < 2)
+    {
+        std::cerr << "usage: bench <in.pcap> [--iterations N]" << std::endl;
+        return 1;
+    }
+    long iterations = 5;
+    if (argc > 3 && std::strcmp(argv[2], "--iterations") == 0)
+        iterations = std::atol(argv[3]);
+    if (iterations <= 0)
+    {
+        std::cerr << "--iterations must be positive" << std::endl;
+        return 1;
+    }
+    std::string error;
+    PcapFile input;
+    if (!input.open(argv[1], error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    NullBuffer nullBuffer;
+    std::streambuf *coutBuffer = std::cout.rdbuf(&nullBuffer);
+    uint64_t messages = 0;
+    uint64_t bestNs = 0;
+    for (long iteration = 0; iteration < iterations; ++iteration)
+    {
+        input.rewind();
+        messages = 0;
+        PcapRecord record;
+        const uint64_t startNs = monotonic_now_ns();
+        while (input.next(record))
+        {
+            const u_char *packet = record.packet;
+            const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(packet, record.hdr->capLen);
+            if (!moldudp64_hdr || !moldudp64_header_check(packet, moldudp64_hdr))
+                continue;
+            decode_and_handle_itch_message_blocks(packet, moldudp64_hdr);
+            messages += moldudp64_hdr->get_message_count();
+        }
+        const uint64_t elapsedNs = monotonic_now_ns() - startNs;
+        if (iteration == 0 || elapsedNs < bestNs)
+            bestNs = elapsedNs;
+    }
+    std::cout.rdbuf(coutBuffer);
+
+    std::printf("messages,%lu\n", messages);
+    std::printf("decode_ns_per_message,%.2f\n", messages ? static_cast<double>(bestNs) / messages : 0.0);
+    std::printf("decode_messages_per_second,%.0f\n", bestNs ? messages * 1e9 / bestNs : 0.0);
+    return 0;
+}
+
 int main(int argc, char const *argv[])
 {
+    if (argc > 1 && std::strcmp(argv[1], "slice") == 0)
+        return run_slice(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "replay") == 0)
+        return run_replay(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "index") == 0)
+        return run_index(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "query") == 0)
+        return run_query(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "auction") == 0)
+        return run_auction(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "combos") == 0)
+        return run_combos(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "checkpoint") == 0)
+        return run_checkpoint(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "resume") == 0)
+        return run_resume(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "stats") == 0)
+        return run_stats(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "diff") == 0)
+        return run_diff(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "generate") == 0)
+        return run_generate(argc - 1, argv + 1);
+    if (argc > 1 && std::strcmp(argv[1], "bench") == 0)
+        return run_bench(argc - 1, argv + 1);
+
     const int lines_to_read=atoi(argv[1]);
     const char *pcap_loc = "/tmp/to_ywu/20240125.pcap";
     char error_buf[PCAP_ERRBUF_SIZE];
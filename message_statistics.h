@@ -0,0 +1,170 @@
+#pragma once
+#include <pcap.h>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "itch_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+#include "arena.h"
+#include "book_table.h"
+
+/** capacity planning counters, no message is formatted
+ * per message type and per Order Book: messages, bytes
+ * per capture: peak messages per millisecond, messages per packet and packet size distributions
+ * per process: arena chunks, huge pages and page faults
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+struct MessageCounters
+{
+    uint64_t messages = 0;
+    uint64_t bytes = 0;  // message length, without the 2 byte length prefix
+};
+
+class MessageStatistics
+{
+public:
+    static constexpr std::size_t MAX_COUNTED_MESSAGES_PER_PACKET = 64;  // last bucket holds the rest
+    static constexpr std::size_t PACKET_SIZE_BUCKET = 64;
+    static constexpr std::size_t PACKET_SIZE_BUCKETS = 1536 / PACKET_SIZE_BUCKET + 1;
+    static constexpr Numeric4_t EXPECTED_BOOKS = 1 << 16;
+
+    MessageStatistics()
+    {
+        mBooks.reserve(EXPECTED_BOOKS);
+    }
+
+    void on_packet(const PcapFile &input, const PcapRecord &record)
+    {
+        const std::size_t caplen = record.hdr->capLen;
+        const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(record.packet, caplen);
+        if (!moldudp64_hdr)
+        {
+            ++mOtherFrames;
+            return;
+        }
+        const uint64_t captureTimeNs = input.get_timestamp_ns(*record.hdr);
+        /** merged captures go back in time, the span is from the earliest to the latest record */
+        if (mPackets == 0 || captureTimeNs < mMinCaptureNs)
+            mMinCaptureNs = captureTimeNs;
+        if (captureTimeNs > mMaxCaptureNs)
+            mMaxCaptureNs = captureTimeNs;
+        ++mPackets;
+        mPacketBytes += caplen;
+        ++mPacketSizes[caplen / PACKET_SIZE_BUCKET < PACKET_SIZE_BUCKETS - 1 ? caplen / PACKET_SIZE_BUCKET : PACKET_SIZE_BUCKETS - 1];
+
+        std::size_t msgCnt = moldudp64_hdr->get_message_count();
+        if (msgCnt == 0xFFFF)
+            msgCnt = 0;
+        ++mMessagesPerPacket[msgCnt < MAX_COUNTED_MESSAGES_PER_PACKET ? msgCnt : MAX_COUNTED_MESSAGES_PER_PACKET];
+
+        const uint64_t millisecond = captureTimeNs / 1000000;
+        if (millisecond != mCurrentMillisecond)
+        {
+            mCurrentMillisecond = millisecond;
+            mCurrentMillisecondMessages = 0;
+        }
+        mCurrentMillisecondMessages += msgCnt;
+        if (mCurrentMillisecondMessages > mPeakMessagesPerMillisecond)
+        {
+            mPeakMessagesPerMillisecond = mCurrentMillisecondMessages;
+            mPeakMillisecond = millisecond;
+        }
+
+        for_each_message_block(record.packet, caplen, *moldudp64_hdr,
+            [this](std::size_t, const MessageBlock *msgBlk)
+            {
+                const MessageInfo *msgInfo = reinterpret_cast<const MessageInfo *>(msgBlk->messageData);
+                const std::size_t msgLen = msgBlk->get_message_len();
+                MessageCounters &type = mTypes[static_cast<uint8_t>(msgInfo->get_message_type())];
+                ++type.messages;
+                type.bytes += msgLen;
+                Numeric4_t orderBookId;
+                if (get_order_book_id(msgInfo, orderBookId))
+                {
+                    MessageCounters &book = mBooks[orderBookId];
+                    ++book.messages;
+                    book.bytes += msgLen;
+                }
+            });
+    }
+
+    void report(std::FILE *out)
+    {
+        const double seconds = (mMaxCaptureNs - mMinCaptureNs) / 1e9;
+        uint64_t messages = 0;
+        for (const MessageCounters &type : mTypes)
+            messages += type.messages;
+
+        std::fprintf(out, "packets,%lu\nbytes,%lu\nmessages,%lu\nother frames,%lu\ncapture seconds,%.6f\n",
+            mPackets, mPacketBytes, messages, mOtherFrames, seconds);
+        std::fprintf(out, "peak messages per millisecond,%lu,%lu\n",
+            mPeakMessagesPerMillisecond, mPeakMillisecond * 1000000);
+
+        std::fprintf(out, "\ntype,messages,bytes,messages per second\n");
+        for (std::size_t i = 0; i < mTypes.size(); ++i)
+        {
+            if (!mTypes[i].messages)
+                continue;
+            /** message types are upper case letters, anything else as hex so the CSV stays printable */
+            char type[8];
+            if (i >= 'A' && i <= 'Z')
+                std::snprintf(type, sizeof(type), "%c", static_cast<char>(i));
+            else
+                std::snprintf(type, sizeof(type), "0x%02lX", i);
+            std::fprintf(out, "%s,%lu,%lu,%.1f\n", type, mTypes[i].messages, mTypes[i].bytes,
+                seconds > 0 ? mTypes[i].messages / seconds : 0.0);
+        }
+
+        std::fprintf(out, "\nmessages per packet,packets\n");
+        for (std::size_t i = 0; i <= MAX_COUNTED_MESSAGES_PER_PACKET; ++i)
+        {
+            if (mMessagesPerPacket[i])
+                std::fprintf(out, "%lu%s,%lu\n", i, i == MAX_COUNTED_MESSAGES_PER_PACKET ? "+" : "", mMessagesPerPacket[i]);
+        }
+
+        std::fprintf(out, "\npacket size,packets\n");
+        for (std::size_t i = 0; i < PACKET_SIZE_BUCKETS; ++i)
+        {
+            if (!mPacketSizes[i])
+                continue;
+            if (i == PACKET_SIZE_BUCKETS - 1)
+                std::fprintf(out, "%lu+,%lu\n", i * PACKET_SIZE_BUCKET, mPacketSizes[i]);
+            else
+                std::fprintf(out, "%lu-%lu,%lu\n", i * PACKET_SIZE_BUCKET, (i + 1) * PACKET_SIZE_BUCKET - 1, mPacketSizes[i]);
+        }
+
+        std::fprintf(out, "\nbook,messages,bytes,messages per second\n");
+        mBooks.for_each([out, seconds](Numeric4_t orderBookId, const MessageCounters &book)
+        {
+            std::fprintf(out, "%u,%lu,%lu,%.1f\n", orderBookId, book.messages, book.bytes,
+                seconds > 0 ? book.messages / seconds : 0.0);
+        });
+
+        report_arena_statistics(out);
+    }
+
+private:
+    std::array<MessageCounters, 256> mTypes{};  // indexed by the message type byte
+    BookTable<MessageCounters> mBooks;
+    std::array<uint64_t, MAX_COUNTED_MESSAGES_PER_PACKET + 1> mMessagesPerPacket{};
+    std::array<uint64_t, PACKET_SIZE_BUCKETS> mPacketSizes{};
+    uint64_t mPackets = 0;
+    uint64_t mPacketBytes = 0;
+    uint64_t mOtherFrames = 0;
+    uint64_t mMinCaptureNs = 0;
+    uint64_t mMaxCaptureNs = 0;
+    uint64_t mCurrentMillisecond = 0;
+    uint64_t mCurrentMillisecondMessages = 0;
+    uint64_t mPeakMessagesPerMillisecond = 0;
+    uint64_t mPeakMillisecond = 0;
+};
+
+} // namespace Midas::XSES::ITCH
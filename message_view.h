@@ -0,0 +1,224 @@
+#pragma once
+#include <pcap.h>
+#include <cstdint>
+#include <cstring>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "itch_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+#include "generator.h"
+
+/** library API, a capture as a sequence of typed message views
+ * a view points into the mapped capture, nothing is copied or formatted,
+ * it stays valid as long as the PcapFile it came from stays open
+ *
+ *     PcapFile input;
+ *     input.open("20240125.pcap", error);
+ *     for (const MessageView &view : read_messages(input))       // pull, C++20
+ *         if (const AddOrder *feed = view.as<AddOrder>()) ...
+ *
+ *     MessageReader reader(input);
+ *     MessageView views[256];
+ *     while (std::size_t n = reader.next_batch(views, 256)) ...  // batch
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+/**
+ * message struct to MessageType tag, checked by MessageView::as
+ */
+template <typename T>
+struct MessageTraits;
+
+#define MESSAGE_TRAITS(Struct, Type) \
+    template <> \
+    struct MessageTraits<Struct> \
+    { \
+        static constexpr MessageType type = MessageType::Type; \
+    };
+
+MESSAGE_TRAITS(Seconds, Seconds)
+MESSAGE_TRAITS(OrderBookDirectory, OrderBookDirectory)
+MESSAGE_TRAITS(CombinationOrderBookLeg, CombinationOrderBookLeg)
+MESSAGE_TRAITS(TickSizeTableEntry, TickSize)
+MESSAGE_TRAITS(SystemEvent, SystemEvent)
+MESSAGE_TRAITS(OrderBookState, OrderBookState)
+MESSAGE_TRAITS(AddOrder, AddOrder)
+MESSAGE_TRAITS(OrderExecuted, OrderExecuted)
+MESSAGE_TRAITS(OrderExecutedWithPrice, OrderExecutedWithPrice)
+MESSAGE_TRAITS(OrderReplace, OrderReplace)
+MESSAGE_TRAITS(OrderDelete, OrderDelete)
+MESSAGE_TRAITS(Trade, TradeMessageIdentifier)
+MESSAGE_TRAITS(EquilibriumPriceUpdate, EquilibriumPriceUpdate)
+
+#undef MESSAGE_TRAITS
+
+struct MessageView
+{
+    const MoldUDP64Header *packetHeader = nullptr;
+    const MessageBlock *block = nullptr;
+    uint64_t sequenceNumber = 0;
+    uint64_t captureTimeNs = 0;  // pcap record timestamp
+    /**
+     * Seconds clock + message nanoseconds, every message but Seconds starts with its nanoseconds
+     * @note 0 until the first Seconds message of the capture
+    */
+    uint64_t itchTimeNs = 0;
+
+    const Alpha_t<SESSION_LENGTH> &get_session() const noexcept
+    {
+        return packetHeader->session;
+    }
+
+    MessageType get_message_type() const noexcept
+    {
+        return get_message_info()->get_message_type();
+    }
+
+    const MessageInfo *get_message_info() const noexcept
+    {
+        return reinterpret_cast<const MessageInfo *>(block->messageData);
+    }
+
+    std::size_t get_message_len() const noexcept
+    {
+        return block->get_message_len();
+    }
+
+    /**
+     * @return nullptr if the message is of another type or too short for T
+    */
+    template <typename T>
+    const T *as() const noexcept
+    {
+        if (get_message_type() != MessageTraits<T>::type || get_message_len() < sizeof(T))
+            return nullptr;
+        return static_cast<const T *>(get_message_info());
+    }
+};
+
+/**
+ * walks every message of every MoldUDP64 packet of a capture, one view at a time or by batch
+ */
+class MessageReader
+{
+public:
+    explicit MessageReader(PcapFile &input)
+        : mInput(input)
+    {
+    }
+
+    bool next(MessageView &view)
+    {
+        for (;;)
+        {
+            while (mMsgIdx == mMsgCnt)
+            {
+                if (!next_packet())
+                    return false;
+            }
+            if (mOffset + sizeof(MessageBlock) + MessageInfo::get_size() > mRecord.hdr->capLen)
+            {
+                mMsgIdx = mMsgCnt;  // truncated, skip the rest of the packet
+                continue;
+            }
+            const MessageBlock *msgBlk = reinterpret_cast<const MessageBlock *>(mRecord.packet + mOffset);
+            if (mOffset + msgBlk->get_size() > mRecord.hdr->capLen)
+            {
+                mMsgIdx = mMsgCnt;
+                continue;
+            }
+            view.packetHeader = mHeader;
+            view.block = msgBlk;
+            view.sequenceNumber = mSeqNum + mMsgIdx;
+            view.captureTimeNs = mCaptureTimeNs;
+            view.itchTimeNs = get_itch_time_ns(view.get_message_info(), msgBlk->get_message_len());
+            mOffset += msgBlk->get_size();
+            ++mMsgIdx;
+            return true;
+        }
+    }
+
+    /**
+     * @return number of views filled, 0 at end of capture
+    */
+    std::size_t next_batch(MessageView *views, std::size_t capacity)
+    {
+        std::size_t count = 0;
+        while (count < capacity && next(views[count]))
+            ++count;
+        return count;
+    }
+
+    /**
+     * the packet of the last view returned, e.g. for packet level statistics
+    */
+    const PcapRecord &get_record() const noexcept
+    {
+        return mRecord;
+    }
+
+private:
+    bool next_packet()
+    {
+        while (mInput.next(mRecord))
+        {
+            mHeader = find_moldudp64_header(mRecord.packet, mRecord.hdr->capLen);
+            if (!mHeader)
+                continue;
+            mMsgCnt = mHeader->get_message_count();
+            if (mMsgCnt == 0xFFFF)
+                mMsgCnt = 0;
+            mMsgIdx = 0;
+            mOffset = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+            mSeqNum = mHeader->get_sequence_number();
+            mCaptureTimeNs = mInput.get_timestamp_ns(*mRecord.hdr);
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t get_itch_time_ns(const MessageInfo *msgInfo, std::size_t msgLen) noexcept
+    {
+        if (msgLen < MessageInfo::get_size() + sizeof(Numeric4_t))
+            return 0;
+        Numeric4_t value;
+        std::memcpy(&value, reinterpret_cast<const u_char *>(msgInfo) + MessageInfo::get_size(), sizeof(value));
+        value = big_endian_to_host(value);
+        if (msgInfo->get_message_type() == MessageType::Seconds)
+        {
+            mSecond = value;
+            return static_cast<uint64_t>(mSecond) * 1000000000ull;
+        }
+        return static_cast<uint64_t>(mSecond) * 1000000000ull + value;
+    }
+
+    PcapFile &mInput;
+    PcapRecord mRecord;
+    const MoldUDP64Header *mHeader = nullptr;
+    std::size_t mMsgCnt = 0;
+    std::size_t mMsgIdx = 0;
+    std::size_t mOffset = 0;
+    uint64_t mSeqNum = 0;
+    uint64_t mCaptureTimeNs = 0;
+    Numeric4_t mSecond = 0;
+};
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+/**
+ * lazy range over the messages of a capture, from its current position
+*/
+inline Generator<MessageView> read_messages(PcapFile &input)
+{
+    MessageReader reader(input);
+    MessageView view;
+    while (reader.next(view))
+        co_yield view;
+}
+#endif
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,220 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "constants.h"
+#include "utils.h"
+#include "itch_protocol.h"
+#include "arena.h"
+#include "book_table.h"
+
+/** market by order state, the live orders of every Order Book and the Order Book trading state
+ * order nodes are recycled through the thread's arena, adds and deletes never reach malloc
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+#pragma pack(push, 1)
+
+/**
+ * order ids are only unique per Order Book and side
+ */
+struct OrderKey
+{
+    Numeric4_t orderBookId;
+    char side;
+    char padding[3];
+    Numeric8_t orderId;
+
+    bool operator==(const OrderKey &other) const noexcept
+    {
+        return orderBookId == other.orderBookId && side == other.side && orderId == other.orderId;
+    }
+    bool operator<(const OrderKey &other) const noexcept
+    {
+        if (orderBookId != other.orderBookId)
+            return orderBookId < other.orderBookId;
+        if (side != other.side)
+            return side < other.side;
+        return orderId < other.orderId;
+    }
+};
+static_assert(sizeof(OrderKey) == 16);
+
+struct LiveOrder
+{
+    Price_t price;
+    Numeric8_t quantity;  // remaining visible quantity
+};
+
+#pragma pack(pop)
+
+struct OrderKeyHash
+{
+    std::size_t operator()(const OrderKey &key) const noexcept
+    {
+        return key.orderId * 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(key.orderBookId) << 8 | key.side);
+    }
+};
+
+/**
+ * @return false for messages that do not belong to an order
+*/
+inline bool get_order_key(const MessageInfo *msgInfo, OrderKey &key) noexcept
+{
+    std::memset(&key, 0, sizeof(key));
+    switch (msgInfo->get_message_type())
+    {
+    case MessageType::AddOrder:
+    {
+        const AddOrder *feed = static_cast<const AddOrder *>(msgInfo);
+        key.orderBookId = big_endian_to_host(feed->mOrderBookId);
+        key.side = feed->mSide;
+        key.orderId = big_endian_to_host(feed->mOrderId);
+        return true;
+    }
+    case MessageType::OrderExecuted:
+    case MessageType::OrderExecutedWithPrice:
+    {
+        const OrderExecuted *feed = static_cast<const OrderExecuted *>(msgInfo);
+        key.orderBookId = big_endian_to_host(feed->mOrderBookId);
+        key.side = feed->mSide;
+        key.orderId = big_endian_to_host(feed->mOrderId);
+        return true;
+    }
+    case MessageType::OrderReplace:
+    {
+        const OrderReplace *feed = static_cast<const OrderReplace *>(msgInfo);
+        key.orderBookId = big_endian_to_host(feed->mOrderBookId);
+        key.side = feed->mSide;
+        key.orderId = big_endian_to_host(feed->mOrderId);
+        return true;
+    }
+    case MessageType::OrderDelete:
+    {
+        const OrderDelete *feed = static_cast<const OrderDelete *>(msgInfo);
+        key.orderBookId = big_endian_to_host(feed->orderBookId);
+        key.side = feed->side;
+        key.orderId = big_endian_to_host(feed->orderId);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+class OrderBooks
+{
+public:
+    void on_message(const MessageInfo *msgInfo)
+    {
+        OrderKey key;
+        switch (msgInfo->get_message_type())
+        {
+        case MessageType::OrderBookState:
+        {
+            const OrderBookState *feed = static_cast<const OrderBookState *>(msgInfo);
+            mStates[big_endian_to_host(feed->mOrderBookId)] = feed->mStateName;
+            break;
+        }
+        case MessageType::AddOrder:
+        {
+            const AddOrder *feed = static_cast<const AddOrder *>(msgInfo);
+            get_order_key(msgInfo, key);
+            mOrders[key] = LiveOrder{big_endian_to_host(feed->mPrice), big_endian_to_host(feed->mQuantity)};
+            break;
+        }
+        case MessageType::OrderExecuted:
+        case MessageType::OrderExecutedWithPrice:
+        {
+            const OrderExecuted *feed = static_cast<const OrderExecuted *>(msgInfo);
+            get_order_key(msgInfo, key);
+            auto it = mOrders.find(key);
+            if (it == mOrders.end())
+                break;
+            /** an undisclosed quantity is not known, such an order stays until deleted */
+            if (it->second.quantity == 0)
+                break;
+            const Numeric8_t executed = big_endian_to_host(feed->mExecutedQuantity);
+            if (executed < it->second.quantity)
+                it->second.quantity -= executed;
+            else
+                mOrders.erase(it);
+            break;
+        }
+        case MessageType::OrderReplace:
+        {
+            const OrderReplace *feed = static_cast<const OrderReplace *>(msgInfo);
+            get_order_key(msgInfo, key);
+            mOrders[key] = LiveOrder{big_endian_to_host(feed->mPrice), big_endian_to_host(feed->mQuantity)};
+            break;
+        }
+        case MessageType::OrderDelete:
+            get_order_key(msgInfo, key);
+            mOrders.erase(key);
+            break;
+        default:
+            break;
+        }
+    }
+
+    const LiveOrder *find(const OrderKey &key) const noexcept
+    {
+        auto it = mOrders.find(key);
+        return it == mOrders.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * restore path, bypasses message handling
+    */
+    void insert(const OrderKey &key, const LiveOrder &order)
+    {
+        mOrders[key] = order;
+    }
+
+    void set_state(Numeric4_t orderBookId, const Alpha_t<20> &stateName)
+    {
+        mStates[orderBookId] = stateName;
+    }
+
+    const Alpha_t<20> *find_state(Numeric4_t orderBookId) const noexcept
+    {
+        return mStates.find(orderBookId);
+    }
+
+    std::size_t get_order_count() const noexcept
+    {
+        return mOrders.size();
+    }
+
+    /**
+     * visit(key, order) in no particular order
+    */
+    template <typename Visitor>
+    void for_each_order(Visitor &&visit) const
+    {
+        for (const auto &[key, order] : mOrders)
+            visit(key, order);
+    }
+
+    template <typename Visitor>
+    void for_each_state(Visitor &&visit)
+    {
+        mStates.for_each(visit);
+    }
+
+    void clear()
+    {
+        mOrders.clear();
+        mStates.clear();
+    }
+
+private:
+    std::unordered_map<OrderKey, LiveOrder, OrderKeyHash, std::equal_to<OrderKey>,
+        ArenaAllocator<std::pair<const OrderKey, LiveOrder>>> mOrders;
+    BookTable<Alpha_t<20>> mStates;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,239 @@
+#pragma once
+#include <pcap.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/mman.h>
+
+#include "constants.h"
+#include "utils.h"
+#include "itch_protocol.h"
+#include "packet_checks.h"
+#include "file_io.h"
+#include "pcap_file.h"
+#include "arena.h"
+#include "order_book.h"
+
+/** order lifecycle store, every event of an order by (Order Book, side, order id)
+ * index file = header + sorted order entries + events grouped per order
+ * an event is the location of the message inside the capture, the capture itself stays the store of record
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+#define ORDER_STORE_MAGIC "XSESOIX1"
+
+#pragma pack(push, 1)
+
+struct OrderEvent
+{
+    uint64_t recordOffset;  // pcap record header, see PcapRecord::offset
+    uint32_t blockOffset;  // message block from the start of the frame
+    uint32_t messageIndex;  // sequence number = MoldUDP64 header sequence number + messageIndex
+};
+static_assert(sizeof(OrderEvent) == 16);
+
+struct OrderEntry
+{
+    OrderKey key;
+    uint64_t firstEvent;
+    uint64_t eventCount;
+};
+
+struct OrderStoreHeader
+{
+    char magic[8];
+    uint64_t captureSize;  // guards against querying with another capture
+    uint64_t orderCount;
+    uint64_t eventCount;
+};
+
+#pragma pack(pop)
+
+/**
+ * one pass over the capture, the event lists grow in an arena and are flattened on write
+ */
+class OrderStoreBuilder
+{
+public:
+    void build(PcapFile &input)
+    {
+        mCaptureSize = input.size();
+        PcapRecord record;
+        input.rewind();
+        while (input.next(record))
+        {
+            const std::size_t caplen = record.hdr->capLen;
+            const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(record.packet, caplen);
+            if (!moldudp64_hdr)
+                continue;
+            for_each_message_block(record.packet, caplen, *moldudp64_hdr,
+                [&](std::size_t msgIdx, const MessageBlock *msgBlk)
+                {
+                    OrderKey key;
+                    if (get_order_key(reinterpret_cast<const MessageInfo *>(msgBlk->messageData), key))
+                        append(key, OrderEvent{record.offset,
+                            static_cast<uint32_t>(reinterpret_cast<const u_char *>(msgBlk) - record.packet),
+                            static_cast<uint32_t>(msgIdx)});
+                });
+        }
+    }
+
+    bool write(const char *path, std::string &error) const
+    {
+        std::vector<OrderEntry> entries;
+        entries.reserve(mOrders.size());
+        for (const auto &[key, list] : mOrders)
+            entries.push_back(OrderEntry{key, 0, list.count});
+        std::sort(entries.begin(), entries.end(),
+            [](const OrderEntry &lhs, const OrderEntry &rhs) { return lhs.key < rhs.key; });
+
+        std::vector<OrderEvent> events;
+        events.reserve(mEventCount);
+        for (OrderEntry &entry : entries)
+        {
+            entry.firstEvent = events.size();
+            for (const EventNode *node = mOrders.at(entry.key).head; node; node = node->next)
+                events.push_back(node->event);
+        }
+
+        OrderStoreHeader header;
+        std::memcpy(header.magic, ORDER_STORE_MAGIC, sizeof(header.magic));
+        header.captureSize = mCaptureSize;
+        header.orderCount = entries.size();
+        header.eventCount = events.size();
+
+        return write_file(path, header, entries, events, error);
+    }
+
+    std::size_t get_order_count() const noexcept
+    {
+        return mOrders.size();
+    }
+
+    std::size_t get_event_count() const noexcept
+    {
+        return mEventCount;
+    }
+
+    const Arena &get_arena() const noexcept
+    {
+        return mArena;
+    }
+
+private:
+    struct EventNode
+    {
+        OrderEvent event;
+        EventNode *next;
+    };
+    struct EventList
+    {
+        EventNode *head = nullptr;
+        EventNode *tail = nullptr;
+        uint64_t count = 0;
+    };
+
+    void append(const OrderKey &key, const OrderEvent &event)
+    {
+        EventNode *node = mArena.create<EventNode>(EventNode{event, nullptr});
+        EventList &list = mOrders[key];
+        if (list.tail)
+            list.tail->next = node;
+        else
+            list.head = node;
+        list.tail = node;
+        ++list.count;
+        ++mEventCount;
+    }
+
+    static bool write_file(const char *path, const OrderStoreHeader &header,
+        const std::vector<OrderEntry> &entries, const std::vector<OrderEvent> &events, std::string &error)
+    {
+        FileWriter output;
+        if (!output.open(path, error))
+            return false;
+        const bool ok = output.write_pod(header)
+            && output.write(entries.data(), entries.size() * sizeof(OrderEntry))
+            && output.write(events.data(), events.size() * sizeof(OrderEvent))
+            && output.close();
+        if (!ok)
+            error = std::string(path) + ": " + std::strerror(errno);
+        return ok;
+    }
+
+    Arena mArena;
+    /** never erased from, the map nodes share the arena of the event lists */
+    std::unordered_map<OrderKey, EventList, OrderKeyHash, std::equal_to<OrderKey>,
+        ArenaAllocator<std::pair<const OrderKey, EventList>>> mOrders{0, OrderKeyHash(), std::equal_to<OrderKey>(),
+        ArenaAllocator<std::pair<const OrderKey, EventList>>(mArena)};
+    uint64_t mEventCount = 0;
+    uint64_t mCaptureSize = 0;
+};
+
+/**
+ * read only view of an index file, lookups are a binary search over the mapped entries
+ */
+class OrderStore
+{
+public:
+    bool open(const char *path, std::string &error)
+    {
+        if (!mFile.open(path, error))
+            return false;
+        mFile.advise(MADV_RANDOM);
+        if (mFile.size() < sizeof(OrderStoreHeader))
+        {
+            error = std::string(path) + ": not an order store";
+            mFile.close();
+            return false;
+        }
+        const OrderStoreHeader &header = get_header();
+        if (std::memcmp(header.magic, ORDER_STORE_MAGIC, sizeof(header.magic)) != 0
+            || mFile.size() != sizeof(OrderStoreHeader) + header.orderCount * sizeof(OrderEntry) + header.eventCount * sizeof(OrderEvent))
+        {
+            error = std::string(path) + ": not an order store";
+            mFile.close();
+            return false;
+        }
+        mEntries = reinterpret_cast<const OrderEntry *>(mFile.data() + sizeof(OrderStoreHeader));
+        mEvents = reinterpret_cast<const OrderEvent *>(mEntries + header.orderCount);
+        return true;
+    }
+
+    const OrderStoreHeader &get_header() const noexcept
+    {
+        return *reinterpret_cast<const OrderStoreHeader *>(mFile.data());
+    }
+
+    /**
+     * @return the events of the order in capture order, nullptr if the order is unknown
+    */
+    const OrderEvent *find(Numeric4_t orderBookId, char side, Numeric8_t orderId, std::size_t &eventCount) const noexcept
+    {
+        OrderKey key;
+        std::memset(&key, 0, sizeof(key));
+        key.orderBookId = orderBookId;
+        key.side = side;
+        key.orderId = orderId;
+        const OrderEntry *end = mEntries + get_header().orderCount;
+        const OrderEntry *entry = std::lower_bound(mEntries, end, key,
+            [](const OrderEntry &lhs, const OrderKey &rhs) { return lhs.key < rhs; });
+        if (entry == end || !(entry->key == key))
+            return nullptr;
+        eventCount = entry->eventCount;
+        return mEvents + entry->firstEvent;
+    }
+
+private:
+    MappedFile mFile;
+    const OrderEntry *mEntries = nullptr;
+    const OrderEvent *mEvents = nullptr;
+};
+
+} // namespace Midas::XSES::ITCH
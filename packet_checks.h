@@ -0,0 +1,128 @@
+#pragma once
+#include <pcap.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "itch_protocol.h"
+
+/** link, network and transport layer checks in front of ITCH decoding
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+inline bool eth_header_check(const u_char *&packet, const ethhdr *&eth_hdr)
+{
+    /**
+     * Data Link, Ethernet: frame = frame header + frame data
+     * */
+    // viewdone: how do we know we should compare ip_hdr->protocal with IPPROTO_UDP, compare eth_hdr->h_proto with ETH_P_IP
+    eth_hdr = reinterpret_cast<const ethhdr *>(packet);
+    // viewdone: ETH_P_IP is defined as 2 byte, but stored as 4 byte, how to specify its data type??? -> static_cast<uint16_t>
+    if (big_endian_to_host(eth_hdr->h_proto) != static_cast<uint16_t>(ETH_P_IP))
+        return false;
+    return true;
+}
+
+inline bool ip_header_check(const ethhdr *&eth_hdr, const iphdr *&ip_hdr)
+{
+    /**
+     * Network, Ip: packet = frame data = packet header + packet data
+     * this packet != packet variable, packet variable is frame
+     * */
+    // viewdone: why eth_hdr+1? -> ptr+1 means ptr+sizeof(type being pointed), so here +1 means +sizeof(eth_hdr)
+    // viewtodo: reinterpret_cast vs static_cast vs dynamic_cast vs const_cast
+    ip_hdr = reinterpret_cast<const iphdr *>(eth_hdr + 1);
+    if (static_cast<unsigned int>(ip_hdr->protocol) != IPPROTO_UDP)
+        return false;
+    return true;
+}
+
+inline bool moldudp64_header_check(const u_char *&packet, const MoldUDP64Header *&moldudp64_hdr)
+{
+    /**
+     * transport, MoldUDP64 message=downstreampacket:
+     * downstreampacket = packet data = downstreampacket header + downstreampacket data
+     * message != message block, message block is in ITCH, message (downstream packet) is in MoldUDP64
+     * */
+    moldudp64_hdr = reinterpret_cast<const MoldUDP64Header *>(packet + UDP_HEADER_LENGTH);
+    const Numeric2_t msgCnt = moldudp64_hdr->get_message_count();
+    if (msgCnt == 0)
+    {
+        // std::cout<<"heartbeat, next expected sequence number: "<<seqNum<<std::endl;
+        // printf("heartbeat, next expected sequence number: %016x\n", seqNum);
+        return false;
+    }
+    if (msgCnt == 0xFFFF)
+    {
+        /**
+         * While the End of Session messages persist,
+         * re-requests may be made on the current session.
+         * This is the last chance to ensure that all messages have been received
+         */
+        // std::cout<<"end of session, next expected sequence number: "<<seqNum<<std::endl;
+        // printf("end of session, next expected sequence number: %016x\n", seqNum);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * IPv4 header checksum, the check field must be zeroed first
+*/
+inline uint16_t ip_checksum(const iphdr *ip_hdr) noexcept
+{
+    const uint16_t *words = reinterpret_cast<const uint16_t *>(ip_hdr);
+    uint32_t sum = 0;
+    for (std::size_t i = 0; i < ip_hdr->ihl * 2u; ++i)
+        sum += words[i];
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(~sum);
+}
+
+/**
+ * Ethernet + IPv4 + UDP framing check for a captured frame of caplen bytes
+ * @return the MoldUDP64 header, nullptr for non-UDP or truncated frames
+ * @note heartbeats and end of session packets are returned as well, check get_message_count()
+*/
+inline const MoldUDP64Header *find_moldudp64_header(const u_char *packet, std::size_t caplen)
+{
+    if (caplen < UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH)
+        return nullptr;
+    const ethhdr *eth_hdr = nullptr;
+    if (!eth_header_check(packet, eth_hdr))
+        return nullptr;
+    const iphdr *ip_hdr = nullptr;
+    if (!ip_header_check(eth_hdr, ip_hdr))
+        return nullptr;
+    return reinterpret_cast<const MoldUDP64Header *>(packet + UDP_HEADER_LENGTH);
+}
+
+/**
+ * walk the message blocks of a MoldUDP64 packet, stops at the first block overrunning caplen
+ * handler(msgIdx, msgBlk) gets the index from the header sequence number and the block
+*/
+template <typename Handler>
+inline void for_each_message_block(const u_char *packet, std::size_t caplen, const MoldUDP64Header &moldudp64_hdr, Handler &&handler)
+{
+    const std::size_t msgCnt = moldudp64_hdr.get_message_count();
+    if (msgCnt == 0xFFFF)
+        return;
+    std::size_t offset = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+    for (std::size_t msgIdx = 0; msgIdx < msgCnt; ++msgIdx)
+    {
+        if (offset + sizeof(MessageBlock) + MessageInfo::get_size() > caplen)
+            return;
+        const MessageBlock *msgBlk = reinterpret_cast<const MessageBlock *>(packet + offset);
+        if (offset + msgBlk->get_size() > caplen)
+            return;
+        handler(msgIdx, msgBlk);
+        offset += msgBlk->get_size();
+    }
+}
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,185 @@
+#pragma once
+#include <pcap.h>
+#include <cstdint>
+#include <string>
+#include <sys/mman.h>
+
+#include "file_io.h"
+
+/** capture file layer, reads and writes the pcap savefile format directly
+ * file = global header + (record header + frame) * n
+ * libpcap copies every frame into its own buffer, here the frames are read in place from the mapping
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+#define PCAP_MAGIC_MICROSECONDS 0xa1b2c3d4
+#define PCAP_MAGIC_NANOSECONDS 0xa1b23c4d
+
+#pragma pack(push, 1)
+
+struct PcapGlobalHeader
+{
+    uint32_t magicNumber;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    int32_t thisZone;
+    uint32_t sigFigs;
+    uint32_t snapLen;
+    uint32_t linkType;
+};
+static_assert(sizeof(PcapGlobalHeader) == 24);
+
+/**
+ * on-disk record header, not struct pcap_pkthdr whose timeval is 16 bytes on 64-bit hosts
+ */
+struct PcapRecordHeader
+{
+    uint32_t tsSec;
+    uint32_t tsFrac;  // microseconds or nanoseconds, see PcapGlobalHeader::magicNumber
+    uint32_t capLen;
+    uint32_t origLen;
+};
+static_assert(sizeof(PcapRecordHeader) == 16);
+
+#pragma pack(pop)
+
+struct PcapRecord
+{
+    const PcapRecordHeader *hdr = nullptr;
+    const u_char *packet = nullptr;  // frame, same as the packet argument of a pcap_loop callback
+    std::size_t offset = 0;  // file offset of the record header
+    std::size_t get_size() const noexcept
+    {
+        return sizeof(PcapRecordHeader) + hdr->capLen;
+    }
+};
+
+class PcapFile
+{
+public:
+    /**
+     * map the whole capture read only
+     * @note only captures written in host byte order are accepted
+    */
+    bool open(const char *path, std::string &error)
+    {
+        if (!mFile.open(path, error))
+            return false;
+        if (mFile.size() < sizeof(PcapGlobalHeader))
+        {
+            error = std::string(path) + ": not a pcap file";
+            mFile.close();
+            return false;
+        }
+        const uint32_t magic = get_global_header().magicNumber;
+        if (magic != PCAP_MAGIC_MICROSECONDS && magic != PCAP_MAGIC_NANOSECONDS)
+        {
+            error = std::string(path) + ": unsupported pcap magic number";
+            mFile.close();
+            return false;
+        }
+        mFile.advise(MADV_SEQUENTIAL);
+        rewind();
+        return true;
+    }
+
+    const PcapGlobalHeader &get_global_header() const noexcept
+    {
+        return *reinterpret_cast<const PcapGlobalHeader *>(mFile.data());
+    }
+
+    bool is_nanosecond() const noexcept
+    {
+        return get_global_header().magicNumber == PCAP_MAGIC_NANOSECONDS;
+    }
+
+    uint64_t get_timestamp_ns(const PcapRecordHeader &hdr) const noexcept
+    {
+        return static_cast<uint64_t>(hdr.tsSec) * 1000000000ull
+            + (is_nanosecond() ? hdr.tsFrac : static_cast<uint64_t>(hdr.tsFrac) * 1000ull);
+    }
+
+    const u_char *data() const noexcept
+    {
+        return mFile.data();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return mFile.size();
+    }
+
+    void rewind() noexcept
+    {
+        mCursor = sizeof(PcapGlobalHeader);
+    }
+
+    /**
+     * continue reading at the record header found at offset, as returned in PcapRecord::offset
+    */
+    bool seek(std::size_t offset) noexcept
+    {
+        if (offset < sizeof(PcapGlobalHeader) || offset > size())
+            return false;
+        mCursor = offset;
+        return true;
+    }
+
+    /**
+     * @return false at end of file or on a truncated last record
+    */
+    bool next(PcapRecord &record) noexcept
+    {
+        if (mCursor + sizeof(PcapRecordHeader) > size())
+            return false;
+        const PcapRecordHeader *hdr = reinterpret_cast<const PcapRecordHeader *>(data() + mCursor);
+        if (mCursor + sizeof(PcapRecordHeader) + hdr->capLen > size())
+            return false;
+        record.hdr = hdr;
+        record.packet = data() + mCursor + sizeof(PcapRecordHeader);
+        record.offset = mCursor;
+        mCursor += sizeof(PcapRecordHeader) + hdr->capLen;
+        return true;
+    }
+
+private:
+    MappedFile mFile;
+    std::size_t mCursor = 0;
+};
+
+/**
+ * savefile writer, the global header first then records or runs of records
+ */
+class PcapWriter
+{
+public:
+    bool open(const char *path, const PcapGlobalHeader &globalHeader, std::string &error)
+    {
+        return mFile.open(path, error) && mFile.write_pod(globalHeader);
+    }
+
+    /**
+     * copy bytes as they are, e.g. a run of records straight from a PcapFile mapping
+    */
+    bool write(const void *data, std::size_t len)
+    {
+        return mFile.write(data, len);
+    }
+
+    bool write_record(const PcapRecordHeader &hdr, const u_char *packet)
+    {
+        return mFile.write_pod(hdr) && mFile.write(packet, hdr.capLen);
+    }
+
+    bool close()
+    {
+        return mFile.close();
+    }
+
+private:
+    FileWriter mFile;
+};
+
+} // namespace Midas::XSES::ITCH
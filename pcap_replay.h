@@ -0,0 +1,255 @@
+#pragma once
+#include <pcap.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <linux/udp.h>
+#include <sys/socket.h>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+#include "arena.h"
+
+/** capture replay, sends the MoldUDP64 payload of every captured frame to a UDP destination
+ * payloads are sent straight from the mapping with sendmmsg, packets due at the same time leave in one batch
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+struct ReplayOptions
+{
+    /**
+     * 1.0 reproduces the captured inter-packet gaps, 2.0 replays twice as fast
+     * @note ignored when maxRate is set
+    */
+    double speed = 1.0;
+    bool maxRate = false;
+    std::size_t batchSize = 32;  // packets per sendmmsg call at most
+};
+
+struct ReplayStatistics
+{
+    uint64_t packets = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;  // UDP payload bytes
+    uint64_t truncatedFrames = 0;  // capture length short of the UDP length, not sent
+    uint64_t sendCalls = 0;
+    uint64_t elapsedNs = 0;
+    uint64_t captureSpanNs = 0;
+    /** send time minus scheduled time, per packet, not measured at max rate */
+    uint64_t totalLatenessNs = 0;
+    uint64_t maxLatenessNs = 0;
+
+    double get_packet_rate() const noexcept
+    {
+        return elapsedNs ? packets * 1e9 / elapsedNs : 0.0;
+    }
+    double get_message_rate() const noexcept
+    {
+        return elapsedNs ? messages * 1e9 / elapsedNs : 0.0;
+    }
+    double get_megabits_per_second() const noexcept
+    {
+        return elapsedNs ? bytes * 8e3 / elapsedNs : 0.0;
+    }
+    double get_achieved_speed() const noexcept
+    {
+        return elapsedNs ? static_cast<double>(captureSpanNs) / elapsedNs : 0.0;
+    }
+    double get_mean_lateness_ns() const noexcept
+    {
+        return packets ? static_cast<double>(totalLatenessNs) / packets : 0.0;
+    }
+};
+
+/**
+ * busy wait, sleeping is far too coarse for microsecond gaps
+*/
+inline uint64_t spin_until_ns(uint64_t deadline) noexcept
+{
+    uint64_t now = monotonic_now_ns();
+    while (now < deadline)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+        now = monotonic_now_ns();
+    }
+    return now;
+}
+
+class PcapReplayer
+{
+public:
+    PcapReplayer() = default;
+    PcapReplayer(const PcapReplayer &) = delete;
+    PcapReplayer &operator=(const PcapReplayer &) = delete;
+    ~PcapReplayer()
+    {
+        if (mFd >= 0)
+            ::close(mFd);
+    }
+
+    bool open(const char *host, uint16_t port, std::string &error)
+    {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = host_to_big_endian(port);
+        if (::inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+        {
+            error = std::string("invalid IPv4 address: ") + host;
+            return false;
+        }
+        mFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (mFd < 0 || ::connect(mFd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            error = std::string("socket: ") + std::strerror(errno);
+            return false;
+        }
+        const int sndbuf = 16 << 20;
+        ::setsockopt(mFd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        return true;
+    }
+
+    bool run(PcapFile &input, const ReplayOptions &options)
+    {
+        const std::size_t batchSize = options.batchSize ? options.batchSize : 1;
+        mMessages.assign(batchSize, mmsghdr());
+        mIovecs.assign(batchSize, iovec());
+        mDeadlines.assign(batchSize, 0);
+
+        PcapRecord record;
+        bool pending = next_payload(input, record);
+        if (!pending)
+            return true;
+        const uint64_t firstCaptureNs = input.get_timestamp_ns(*record.hdr);
+        /** merged captures go back in time, an earlier record is due with the latest one seen so far */
+        uint64_t latestCaptureNs = firstCaptureNs;
+        const uint64_t startNs = monotonic_now_ns();
+        const double scale = options.maxRate ? 0.0 : 1.0 / options.speed;
+
+        while (pending)
+        {
+            std::size_t count = 0;
+            uint64_t now = 0;
+            do
+            {
+                const uint64_t captureNs = input.get_timestamp_ns(*record.hdr);
+                if (captureNs > latestCaptureNs)
+                    latestCaptureNs = captureNs;
+                const uint64_t deadline = startNs + static_cast<uint64_t>((latestCaptureNs - firstCaptureNs) * scale);
+                if (count == 0)
+                    now = spin_until_ns(deadline);
+                else if (deadline > now)
+                    break;  // not due yet, keeps for the next batch
+                add_to_batch(count++, record, deadline);
+                pending = next_payload(input, record);
+            } while (pending && count < batchSize);
+
+            if (!send_batch(count))
+                return false;
+            if (options.maxRate)
+                continue;
+            const uint64_t sentNs = monotonic_now_ns();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const uint64_t lateness = sentNs - mDeadlines[i];
+                mStatistics.totalLatenessNs += lateness;
+                if (lateness > mStatistics.maxLatenessNs)
+                    mStatistics.maxLatenessNs = lateness;
+            }
+        }
+        mStatistics.elapsedNs = monotonic_now_ns() - startNs;
+        mStatistics.captureSpanNs = latestCaptureNs - firstCaptureNs;
+        return true;
+    }
+
+    const ReplayStatistics &get_statistics() const noexcept
+    {
+        return mStatistics;
+    }
+
+private:
+    /**
+     * skip to the next frame carrying a whole MoldUDP64 packet, heartbeats included
+    */
+    bool next_payload(PcapFile &input, PcapRecord &record) noexcept
+    {
+        while (input.next(record))
+        {
+            if (!find_moldudp64_header(record.packet, record.hdr->capLen))
+                continue;
+            const std::size_t payloadLen = get_payload_length(record);
+            if (payloadLen >= DOWNSTREAMPACKET_HEADER_LENGTH && UDP_HEADER_LENGTH + payloadLen <= record.hdr->capLen)
+                return true;
+            ++mStatistics.truncatedFrames;
+        }
+        return false;
+    }
+
+    /**
+     * from the UDP length, the capture length also counts an Ethernet trailer or FCS
+    */
+    static std::size_t get_payload_length(const PcapRecord &record) noexcept
+    {
+        const udphdr *udp_hdr = reinterpret_cast<const udphdr *>(record.packet + sizeof(ethhdr) + sizeof(iphdr));
+        const std::size_t udpLen = big_endian_to_host(udp_hdr->len);
+        return udpLen > sizeof(udphdr) ? udpLen - sizeof(udphdr) : 0;
+    }
+
+    void add_to_batch(std::size_t idx, const PcapRecord &record, uint64_t deadline) noexcept
+    {
+        const MoldUDP64Header *moldudp64_hdr = reinterpret_cast<const MoldUDP64Header *>(record.packet + UDP_HEADER_LENGTH);
+        const std::size_t msgCnt = moldudp64_hdr->get_message_count();
+        iovec &iov = mIovecs[idx];
+        iov.iov_base = const_cast<u_char *>(record.packet + UDP_HEADER_LENGTH);
+        iov.iov_len = get_payload_length(record);
+        msghdr &msg = mMessages[idx].msg_hdr;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        mDeadlines[idx] = deadline;
+
+        ++mStatistics.packets;
+        mStatistics.bytes += iov.iov_len;
+        if (msgCnt != 0xFFFF)
+            mStatistics.messages += msgCnt;
+    }
+
+    bool send_batch(std::size_t count) noexcept
+    {
+        std::size_t sent = 0;
+        while (sent < count)
+        {
+            const int rc = ::sendmmsg(mFd, mMessages.data() + sent, count - sent, 0);
+            ++mStatistics.sendCalls;
+            if (rc < 0)
+            {
+                /** ECONNREFUSED reports an ICMP error for an earlier datagram, nobody listening yet */
+                if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS || errno == ECONNREFUSED)
+                    continue;
+                return false;
+            }
+            sent += rc;
+        }
+        return true;
+    }
+
+    int mFd = -1;
+    std::vector<mmsghdr, ArenaAllocator<mmsghdr>> mMessages;
+    std::vector<iovec, ArenaAllocator<iovec>> mIovecs;
+    std::vector<uint64_t, ArenaAllocator<uint64_t>> mDeadlines;
+    ReplayStatistics mStatistics;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,259 @@
+#pragma once
+#include <pcap.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+#include <vector>
+#include <linux/ip.h>
+#include <linux/udp.h>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "itch_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+
+/** capture slicing, keeps the frames of some sessions, sequence ranges or Order Books
+ * frames that qualify as a whole are copied byte for byte, nothing is decoded
+ * frames that qualify in part are re-packed as valid MoldUDP64 packets with the remaining message blocks,
+ * one packet per run of consecutive kept messages
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+struct SliceFilter
+{
+    bool hasSession = false;
+    Alpha_t<SESSION_LENGTH> session;
+    uint64_t firstSequenceNumber = 0;
+    uint64_t lastSequenceNumber = std::numeric_limits<uint64_t>::max();  // inclusive
+    /**
+     * empty means every Order Book
+     * @note messages without an Order Book (Seconds, SystemEvent) are always kept,
+     * the slice stays a replayable feed with its clock
+    */
+    std::unordered_set<Numeric4_t> orderBookIds;
+
+    bool match_session(const MoldUDP64Header &moldudp64_hdr) const noexcept
+    {
+        return !hasSession || moldudp64_hdr.session == session;
+    }
+
+    bool match_message(uint64_t seqNum, const MessageInfo *msgInfo) const
+    {
+        if (seqNum < firstSequenceNumber || seqNum > lastSequenceNumber)
+            return false;
+        if (orderBookIds.empty())
+            return true;
+        Numeric4_t orderBookId;
+        if (!get_order_book_id(msgInfo, orderBookId))
+            return true;
+        return orderBookIds.count(orderBookId) != 0;
+    }
+};
+
+struct SliceStatistics
+{
+    uint64_t framesRead = 0;
+    uint64_t framesCopied = 0;
+    uint64_t framesRepacked = 0;
+    uint64_t repackedPacketsWritten = 0;  // one per run of consecutive kept messages
+    uint64_t framesDropped = 0;
+    uint64_t messagesKept = 0;
+    uint64_t messagesDropped = 0;
+};
+
+class PcapSlicer
+{
+public:
+    explicit PcapSlicer(const SliceFilter &filter)
+        : mFilter(filter)
+    {
+    }
+
+    bool run(PcapFile &input, PcapWriter &output)
+    {
+        /** consecutive qualifying records are written as one run straight from the mapping */
+        std::size_t runBegin = 0;
+        std::size_t runEnd = 0;
+        PcapRecord record;
+        input.rewind();
+        while (input.next(record))
+        {
+            ++mStatistics.framesRead;
+            const Verdict verdict = classify(record);
+            if (verdict == Verdict::Copy)
+            {
+                ++mStatistics.framesCopied;
+                if (runEnd != record.offset)
+                {
+                    if (!output.write(input.data() + runBegin, runEnd - runBegin))
+                        return false;
+                    runBegin = record.offset;
+                }
+                runEnd = record.offset + record.get_size();
+                continue;
+            }
+            if (verdict == Verdict::Drop)
+            {
+                ++mStatistics.framesDropped;
+                continue;
+            }
+            ++mStatistics.framesRepacked;
+            if (!output.write(input.data() + runBegin, runEnd - runBegin))
+                return false;
+            runBegin = runEnd = 0;
+            if (!write_repacked(record, output))
+                return false;
+        }
+        return output.write(input.data() + runBegin, runEnd - runBegin);
+    }
+
+    const SliceStatistics &get_statistics() const noexcept
+    {
+        return mStatistics;
+    }
+
+private:
+    enum class Verdict
+    {
+        Drop,
+        Copy,
+        Repack
+    };
+
+    Verdict classify(const PcapRecord &record)
+    {
+        const std::size_t caplen = record.hdr->capLen;
+        const MoldUDP64Header *moldudp64_hdr = find_moldudp64_header(record.packet, caplen);
+        if (!moldudp64_hdr || !mFilter.match_session(*moldudp64_hdr))
+            return Verdict::Drop;
+
+        const uint64_t seqNum = moldudp64_hdr->get_sequence_number();
+        const std::size_t msgCnt = moldudp64_hdr->get_message_count();
+        if (msgCnt == 0 || msgCnt == 0xFFFF)
+        {
+            /** heartbeat or end of session, seqNum is the next expected one */
+            if (seqNum < mFilter.firstSequenceNumber || (seqNum > 0 && seqNum - 1 > mFilter.lastSequenceNumber))
+                return Verdict::Drop;
+            return Verdict::Copy;
+        }
+
+        mKeptBlocks.clear();
+        std::size_t offset = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+        for (std::size_t msgIdx = 0; msgIdx < msgCnt; ++msgIdx)
+        {
+            if (offset + sizeof(MessageBlock) + MessageInfo::get_size() > caplen)
+                return Verdict::Drop;
+            const MessageBlock *msgBlk = reinterpret_cast<const MessageBlock *>(record.packet + offset);
+            if (offset + msgBlk->get_size() > caplen)
+                return Verdict::Drop;
+            const MessageInfo *msgInfo = reinterpret_cast<const MessageInfo *>(msgBlk->messageData);
+            if (mFilter.match_message(seqNum + msgIdx, msgInfo))
+                mKeptBlocks.push_back(KeptBlock{seqNum + msgIdx, msgBlk});
+            offset += msgBlk->get_size();
+        }
+        mStatistics.messagesKept += mKeptBlocks.size();
+        mStatistics.messagesDropped += msgCnt - mKeptBlocks.size();
+        if (mKeptBlocks.empty())
+            return Verdict::Drop;
+        if (mKeptBlocks.size() == msgCnt)
+            return Verdict::Copy;
+        return Verdict::Repack;
+    }
+
+    /**
+     * MoldUDP64 numbers messages implicitly from the header sequence number,
+     * so a run of consecutive kept messages is one packet, a dropped message starts the next one
+     * @note a run longer than the repack buffer is split, a message that cannot fit in any frame is dropped
+    */
+    bool write_repacked(const PcapRecord &record, PcapWriter &output)
+    {
+        const std::size_t headerLength = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+        std::size_t runBegin = 0;
+        std::size_t offset = headerLength;
+        for (std::size_t i = 0; i < mKeptBlocks.size(); ++i)
+        {
+            const std::size_t blockSize = mKeptBlocks[i].block->get_size();
+            const bool oversized = headerLength + blockSize > mRepacked.size();
+            if (i > runBegin && (oversized || mKeptBlocks[i].seqNum != mKeptBlocks[i - 1].seqNum + 1
+                || offset + blockSize > mRepacked.size()))
+            {
+                if (!write_run(record, runBegin, i, output))
+                    return false;
+                runBegin = i;
+                offset = headerLength;
+            }
+            if (oversized)
+            {
+                --mStatistics.messagesKept;
+                ++mStatistics.messagesDropped;
+                runBegin = i + 1;
+                continue;
+            }
+            offset += blockSize;
+        }
+        if (runBegin < mKeptBlocks.size())
+            return write_run(record, runBegin, mKeptBlocks.size(), output);
+        return true;
+    }
+
+    bool write_run(const PcapRecord &record, std::size_t begin, std::size_t end, PcapWriter &output)
+    {
+        repack(record, begin, end);
+        if (!output.write_record(mRepackedHeader, mRepacked.data()))
+            return false;
+        ++mStatistics.repackedPacketsWritten;
+        return true;
+    }
+
+    /**
+     * @param begin, end run of consecutive kept messages in mKeptBlocks, checked by write_repacked to fit mRepacked
+    */
+    void repack(const PcapRecord &record, std::size_t begin, std::size_t end)
+    {
+        u_char *frame = mRepacked.data();
+        std::memcpy(frame, record.packet, UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH);
+        std::size_t offset = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const MessageBlock *msgBlk = mKeptBlocks[i].block;
+            std::memcpy(frame + offset, msgBlk, msgBlk->get_size());
+            offset += msgBlk->get_size();
+        }
+
+        MoldUDP64Header *repacked_hdr = reinterpret_cast<MoldUDP64Header *>(frame + UDP_HEADER_LENGTH);
+        repacked_hdr->sequenceNumber = host_to_big_endian<uint64_t>(mKeptBlocks[begin].seqNum);
+        repacked_hdr->messageCount = host_to_big_endian<uint16_t>(end - begin);
+
+        iphdr *ip_hdr = reinterpret_cast<iphdr *>(frame + sizeof(ethhdr));
+        udphdr *udp_hdr = reinterpret_cast<udphdr *>(frame + sizeof(ethhdr) + sizeof(iphdr));
+        ip_hdr->tot_len = host_to_big_endian<uint16_t>(offset - sizeof(ethhdr));
+        ip_hdr->check = 0;
+        ip_hdr->check = ip_checksum(ip_hdr);
+        udp_hdr->len = host_to_big_endian<uint16_t>(offset - sizeof(ethhdr) - sizeof(iphdr));
+        udp_hdr->check = 0;  // optional over IPv4
+
+        mRepackedHeader = *record.hdr;
+        mRepackedHeader.capLen = offset;
+        mRepackedHeader.origLen = offset;
+    }
+
+    const SliceFilter mFilter;
+    SliceStatistics mStatistics;
+    struct KeptBlock
+    {
+        uint64_t seqNum;
+        const MessageBlock *block;
+    };
+
+    std::vector<KeptBlock> mKeptBlocks;
+    PcapRecordHeader mRepackedHeader;
+    std::array<u_char, 0x10000> mRepacked;
+};
+
+} // namespace Midas::XSES::ITCH
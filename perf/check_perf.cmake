@@ -0,0 +1,59 @@
+# cmake -DRESULTS=<bench output> -DBASELINE=<baseline.csv> -P check_perf.cmake
+# bench output: metric,value lines
+# baseline: metric,baseline value,tolerance in percent lines, # comments, every metric lower is better
+# fails when a metric is missing or slower than baseline * (1 + tolerance / 100)
+
+if(NOT RESULTS OR NOT BASELINE)
+    message(FATAL_ERROR "usage: cmake -DRESULTS=<bench output> -DBASELINE=<baseline.csv> -P check_perf.cmake")
+endif()
+
+# cmake math is integer only, 12.3 -> 1230
+function(to_hundredths decimal out)
+    if(NOT decimal MATCHES "^([0-9]+)(\\.([0-9]*))?$")
+        message(FATAL_ERROR "not a number: ${decimal}")
+    endif()
+    set(integer ${CMAKE_MATCH_1})
+    string(SUBSTRING "${CMAKE_MATCH_3}00" 0 2 fraction)
+    math(EXPR hundredths "${integer} * 100 + 1${fraction} - 100")
+    set(${out} ${hundredths} PARENT_SCOPE)
+endfunction()
+
+file(STRINGS ${RESULTS} resultLines)
+foreach(line IN LISTS resultLines)
+    string(REPLACE "," ";" fields "${line}")
+    list(LENGTH fields fieldCount)
+    if(fieldCount EQUAL 2)
+        list(GET fields 0 metric)
+        list(GET fields 1 value)
+        set(result_${metric} ${value})
+    endif()
+endforeach()
+
+set(failed FALSE)
+file(STRINGS ${BASELINE} baselineLines REGEX "^[^#]")
+foreach(line IN LISTS baselineLines)
+    string(REPLACE "," ";" fields "${line}")
+    list(GET fields 0 metric)
+    list(GET fields 1 baseline)
+    list(GET fields 2 tolerance)
+    if(NOT DEFINED result_${metric})
+        message(SEND_ERROR "${metric}: not in ${RESULTS}")
+        set(failed TRUE)
+        continue()
+    endif()
+    set(value ${result_${metric}})
+    to_hundredths(${value} valueHundredths)
+    to_hundredths(${baseline} baselineHundredths)
+    math(EXPR limitHundredths "${baselineHundredths} * (100 + ${tolerance}) / 100")
+    math(EXPR changePercent "(${valueHundredths} - ${baselineHundredths}) * 100 / ${baselineHundredths}")
+    if(valueHundredths GREATER limitHundredths)
+        message(SEND_ERROR "${metric}: ${value}, baseline ${baseline}, ${changePercent}% over, tolerance ${tolerance}%")
+        set(failed TRUE)
+    else()
+        message(STATUS "${metric}: ${value}, baseline ${baseline}, ${changePercent}%")
+    endif()
+endforeach()
+
+if(failed)
+    message(FATAL_ERROR "performance regression against ${BASELINE}")
+endif()
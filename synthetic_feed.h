@@ -0,0 +1,404 @@
+#pragma once
+#include <pcap.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+
+#include "constants.h"
+#include "utils.h"
+#include "moldudp64_protocol.h"
+#include "itch_protocol.h"
+#include "packet_checks.h"
+#include "pcap_file.h"
+
+/** synthetic ITCH capture, the reproducible workload behind the benchmark and the PGO training run
+ * one session: start of messages, reference data and OPEN state for every book, then a continuous market
+ * mix close to a trading day (adds and deletes first, executions, replaces, equilibrium updates, trades),
+ * a Seconds message every simulated second, end of messages and an end of session packet
+ * the same options and seed always give the same bytes, the generator draws from mt19937_64 only
+ */
+
+namespace Midas::XSES::ITCH
+{
+
+#define MAX_FRAME_LENGTH 1514  // Ethernet header + 1500 byte MTU
+
+struct SyntheticFeedOptions
+{
+    uint64_t messages = 1000000;  // market messages, reference data and Seconds excluded
+    uint64_t seed = 1;
+    Numeric4_t books = 500;
+    std::size_t maxMessagesPerPacket = 16;
+    std::size_t maxLiveOrders = 50000;
+    Numeric4_t startSecond = 32400;  // 09:00
+};
+
+class SyntheticFeed
+{
+public:
+    explicit SyntheticFeed(const SyntheticFeedOptions &options)
+        : mOptions(options), mRandom(options.seed)
+    {
+        mSession.fill(' ');
+        std::memcpy(mSession.data(), "SYNTH00001", SESSION_LENGTH);
+        mLiveOrders.reserve(options.maxLiveOrders);
+    }
+
+    bool write(const char *path, std::string &error)
+    {
+        PcapGlobalHeader globalHeader;
+        globalHeader.magicNumber = PCAP_MAGIC_NANOSECONDS;
+        globalHeader.versionMajor = 2;
+        globalHeader.versionMinor = 4;
+        globalHeader.thisZone = 0;
+        globalHeader.sigFigs = 0;
+        globalHeader.snapLen = 0xFFFF;
+        globalHeader.linkType = 1;  // Ethernet
+        if (!mOutput.open(path, globalHeader, error))
+            return false;
+
+        mSecond = mOptions.startSecond;
+        bool ok = add_seconds() && add_system_event('O');
+        for (Numeric4_t book = 1; ok && book <= mOptions.books; ++book)
+            ok = add_reference_data(book);
+        ok = ok && flush_packet();
+
+        for (uint64_t i = 0; ok && i < mOptions.messages; ++i)
+        {
+            mNanoseconds += 1 + draw(20000);
+            if (mNanoseconds >= 1000000000)
+            {
+                mNanoseconds -= 1000000000;
+                ++mSecond;
+                ok = add_seconds();
+            }
+            ok = ok && add_market_message();
+        }
+
+        ok = ok && add_system_event('C')
+            && flush_packet()
+            && write_packet(0xFFFF);  // end of session
+        if (!ok || !mOutput.close())
+        {
+            error = std::string(path) + ": " + std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t get_packet_count() const noexcept
+    {
+        return mPackets;
+    }
+
+    uint64_t get_message_count() const noexcept
+    {
+        return mSequenceNumber - 1;
+    }
+
+private:
+    struct GeneratedOrder
+    {
+        Numeric8_t orderId;
+        Numeric4_t orderBookId;
+        char side;
+        Price_t price;
+        Numeric8_t quantity;
+    };
+
+    uint64_t draw(uint64_t bound) noexcept
+    {
+        return mRandom() % bound;
+    }
+
+    template <typename T>
+    T make(MessageType type)
+    {
+        T msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.messageType = type;
+        return msg;
+    }
+
+    bool add_seconds()
+    {
+        Seconds msg = make<Seconds>(MessageType::Seconds);
+        msg.second = host_to_big_endian(mSecond);
+        return append(msg);
+    }
+
+    bool add_system_event(char eventCode)
+    {
+        SystemEvent msg = make<SystemEvent>(MessageType::SystemEvent);
+        msg.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.mEventCode = eventCode;
+        return append(msg);
+    }
+
+    bool add_reference_data(Numeric4_t orderBookId)
+    {
+        OrderBookDirectory directory = make<OrderBookDirectory>(MessageType::OrderBookDirectory);
+        directory.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        directory.mOrderBookId = host_to_big_endian(orderBookId);
+        const std::string symbol = "SYN" + std::to_string(orderBookId);
+        directory.mSymbol.fill(' ');
+        directory.mLongName.fill(' ');
+        directory.mIsin.fill(' ');
+        std::memcpy(directory.mSymbol.data(), symbol.data(), symbol.size());
+        std::memcpy(directory.mLongName.data(), symbol.data(), symbol.size());
+        directory.mFinancialProduct = FinancialProduct::Cash;
+        std::memcpy(directory.mTradingCurrency.data(), "SGD", 3);
+        directory.mNumberOfDecimalsInPrice = host_to_big_endian<Numeric2_t>(3);
+        directory.mRoundLotSize = host_to_big_endian<Numeric4_t>(100);
+        if (!append(directory))
+            return false;
+
+        TickSizeTableEntry tickSize = make<TickSizeTableEntry>(MessageType::TickSize);
+        tickSize.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        tickSize.mOrderBookId = host_to_big_endian(orderBookId);
+        tickSize.mTickSize = host_to_big_endian<Numeric8_t>(5);
+        if (!append(tickSize))
+            return false;
+
+        OrderBookState state = make<OrderBookState>(MessageType::OrderBookState);
+        state.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        state.mOrderBookId = host_to_big_endian(orderBookId);
+        state.mStateName.fill(' ');
+        std::memcpy(state.mStateName.data(), "OPEN", 4);
+        return append(state);
+    }
+
+    /**
+     * in percent: 42 add, 30 delete, 12 executed, 3 executed with price, 3 replace, 6 equilibrium, 4 trade
+    */
+    bool add_market_message()
+    {
+        const uint64_t kind = draw(100);
+        const bool full = mLiveOrders.size() >= mOptions.maxLiveOrders;
+        if (mLiveOrders.empty() || (kind < 42 && !full))
+            return add_order();
+        if (kind < 72 || full)
+            return delete_order();
+        if (kind < 87)
+            return execute_order(kind >= 84);
+        if (kind < 90)
+            return replace_order();
+        if (kind < 96)
+            return add_equilibrium();
+        return add_trade();
+    }
+
+    bool add_order()
+    {
+        GeneratedOrder order;
+        order.orderId = mNextOrderId++;
+        order.orderBookId = 1 + draw(mOptions.books);
+        order.side = draw(2) ? 'B' : 'S';
+        order.price = 10000 + static_cast<Price_t>(draw(200)) * 5;
+        order.quantity = 100 * (1 + draw(50));
+        mLiveOrders.push_back(order);
+
+        AddOrder msg = make<AddOrder>(MessageType::AddOrder);
+        msg.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.mOrderId = host_to_big_endian(order.orderId);
+        msg.mOrderBookId = host_to_big_endian(order.orderBookId);
+        msg.mSide = order.side;
+        msg.mOrderBookPosition = host_to_big_endian<Numeric4_t>(1 + draw(20));
+        msg.mQuantity = host_to_big_endian(order.quantity);
+        msg.mPrice = host_to_big_endian(order.price);
+        return append(msg);
+    }
+
+    bool delete_order()
+    {
+        const std::size_t index = draw(mLiveOrders.size());
+        const GeneratedOrder &order = mLiveOrders[index];
+        OrderDelete msg = make<OrderDelete>(MessageType::OrderDelete);
+        msg.timestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.orderId = host_to_big_endian(order.orderId);
+        msg.orderBookId = host_to_big_endian(order.orderBookId);
+        msg.side = order.side;
+        const bool ok = append(msg);
+        remove_order(index);
+        return ok;
+    }
+
+    bool execute_order(bool withPrice)
+    {
+        const std::size_t index = draw(mLiveOrders.size());
+        GeneratedOrder &order = mLiveOrders[index];
+        const Numeric8_t executed = draw(2) ? order.quantity : 100 * (1 + draw(order.quantity / 100));
+        OrderExecutedWithPrice msg = make<OrderExecutedWithPrice>(
+            withPrice ? MessageType::OrderExecutedWithPrice : MessageType::OrderExecuted);
+        msg.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.mOrderId = host_to_big_endian(order.orderId);
+        msg.mOrderBookId = host_to_big_endian(order.orderBookId);
+        msg.mSide = order.side;
+        msg.mExecutedQuantity = host_to_big_endian(executed);
+        msg.mMatchId = host_to_big_endian(mNextMatchId++);
+        if (withPrice)
+        {
+            msg.mTradePrice = host_to_big_endian(order.price);
+            msg.mOccurredAtCross = 'N';
+            msg.mPrintable = 'Y';
+        }
+        const bool ok = withPrice ? append(msg) : append(static_cast<const OrderExecuted &>(msg));
+        if (executed >= order.quantity)
+            remove_order(index);
+        else
+            order.quantity -= executed;
+        return ok;
+    }
+
+    bool replace_order()
+    {
+        GeneratedOrder &order = mLiveOrders[draw(mLiveOrders.size())];
+        order.price += draw(2) ? 5 : -5;
+        order.quantity = 100 * (1 + draw(50));
+        OrderReplace msg = make<OrderReplace>(MessageType::OrderReplace);
+        msg.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.mOrderId = host_to_big_endian(order.orderId);
+        msg.mOrderBookId = host_to_big_endian(order.orderBookId);
+        msg.mSide = order.side;
+        msg.mNewOrderBookPosition = host_to_big_endian<Numeric4_t>(1 + draw(20));
+        msg.mQuantity = host_to_big_endian(order.quantity);
+        msg.mPrice = host_to_big_endian(order.price);
+        return append(msg);
+    }
+
+    bool add_equilibrium()
+    {
+        const Price_t price = 10000 + static_cast<Price_t>(draw(200)) * 5;
+        EquilibriumPriceUpdate msg = make<EquilibriumPriceUpdate>(MessageType::EquilibriumPriceUpdate);
+        msg.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.mOrderBookId = host_to_big_endian<Numeric4_t>(1 + draw(mOptions.books));
+        msg.mAvailableBidQuantityAtEquilibriumPrice = host_to_big_endian<Numeric8_t>(100 * draw(100));
+        msg.mAvailableAskQuantityAtEquilibriumPrice = host_to_big_endian<Numeric8_t>(100 * draw(100));
+        msg.mEquilibriumPrice = host_to_big_endian(price);
+        msg.mBestBidPrice = host_to_big_endian(price - 5);
+        msg.mBestAskPrice = host_to_big_endian(price + 5);
+        msg.mBestBidQuantity = host_to_big_endian<Numeric8_t>(100 * draw(100));
+        msg.mBestAskQuantity = host_to_big_endian<Numeric8_t>(100 * draw(100));
+        return append(msg);
+    }
+
+    bool add_trade()
+    {
+        Trade msg = make<Trade>(MessageType::TradeMessageIdentifier);
+        msg.mTimestampNanoseconds = host_to_big_endian(mNanoseconds);
+        msg.mMatchId = host_to_big_endian(mNextMatchId++);
+        msg.mSide = draw(2) ? 'B' : 'S';
+        msg.mQuantity = host_to_big_endian<Numeric8_t>(100 * (1 + draw(50)));
+        msg.mOrderBookId = host_to_big_endian<Numeric4_t>(1 + draw(mOptions.books));
+        msg.mTradePrice = host_to_big_endian(10000 + static_cast<Price_t>(draw(200)) * 5);
+        msg.mPrintable = 'Y';
+        msg.mOccurredAtCross = 'N';
+        return append(msg);
+    }
+
+    void remove_order(std::size_t index)
+    {
+        mLiveOrders[index] = mLiveOrders.back();
+        mLiveOrders.pop_back();
+    }
+
+    /**
+     * packets close after a random number of messages, or before overflowing the MTU
+     * @return false if closing the previous packet failed to write
+    */
+    template <typename T>
+    bool append(const T &msg)
+    {
+        if (mPacketMessages && (mPacketLength + sizeof(uint16_t) + sizeof(T) > MAX_FRAME_LENGTH
+            || mPacketMessages >= mPacketTarget) && !flush_packet())
+            return false;
+        if (mPacketMessages == 0)
+        {
+            mPacketLength = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+            mPacketTarget = 1 + draw(mOptions.maxMessagesPerPacket);
+        }
+        const uint16_t msgLen = host_to_big_endian<uint16_t>(sizeof(T));
+        std::memcpy(mFrame.data() + mPacketLength, &msgLen, sizeof(msgLen));
+        std::memcpy(mFrame.data() + mPacketLength + sizeof(msgLen), &msg, sizeof(T));
+        mPacketLength += sizeof(msgLen) + sizeof(T);
+        ++mPacketMessages;
+        return true;
+    }
+
+    bool flush_packet()
+    {
+        if (mPacketMessages == 0)
+            return true;
+        if (!write_packet(mPacketMessages))
+            return false;
+        mSequenceNumber += mPacketMessages;
+        mPacketMessages = 0;
+        return true;
+    }
+
+    bool write_packet(uint16_t msgCnt)
+    {
+        if (msgCnt == 0xFFFF)
+            mPacketLength = UDP_HEADER_LENGTH + DOWNSTREAMPACKET_HEADER_LENGTH;
+        u_char *frame = mFrame.data();
+        std::memset(frame, 0, UDP_HEADER_LENGTH);
+        ethhdr *eth_hdr = reinterpret_cast<ethhdr *>(frame);
+        const u_char multicast[ETH_ALEN] = {0x01, 0x00, 0x5E, 0x01, 0x01, 0x01};
+        std::memcpy(eth_hdr->h_dest, multicast, ETH_ALEN);
+        eth_hdr->h_proto = host_to_big_endian<uint16_t>(ETH_P_IP);
+
+        iphdr *ip_hdr = reinterpret_cast<iphdr *>(frame + sizeof(ethhdr));
+        ip_hdr->version = 4;
+        ip_hdr->ihl = 5;
+        ip_hdr->tot_len = host_to_big_endian<uint16_t>(mPacketLength - sizeof(ethhdr));
+        ip_hdr->ttl = 64;
+        ip_hdr->protocol = IPPROTO_UDP;
+        ip_hdr->saddr = host_to_big_endian<uint32_t>(0x0A000001);  // 10.0.0.1
+        ip_hdr->daddr = host_to_big_endian<uint32_t>(0xEF010101);  // 239.1.1.1
+        ip_hdr->check = ip_checksum(ip_hdr);
+
+        udphdr *udp_hdr = reinterpret_cast<udphdr *>(frame + sizeof(ethhdr) + sizeof(iphdr));
+        udp_hdr->source = host_to_big_endian<uint16_t>(30000);
+        udp_hdr->dest = host_to_big_endian<uint16_t>(30001);
+        udp_hdr->len = host_to_big_endian<uint16_t>(mPacketLength - sizeof(ethhdr) - sizeof(iphdr));
+
+        MoldUDP64Header *moldudp64_hdr = reinterpret_cast<MoldUDP64Header *>(frame + UDP_HEADER_LENGTH);
+        moldudp64_hdr->session = mSession;
+        moldudp64_hdr->sequenceNumber = host_to_big_endian(mSequenceNumber);
+        moldudp64_hdr->messageCount = host_to_big_endian(msgCnt);
+
+        PcapRecordHeader hdr;
+        hdr.tsSec = mSecond;
+        hdr.tsFrac = mNanoseconds;
+        hdr.capLen = mPacketLength;
+        hdr.origLen = mPacketLength;
+        if (!mOutput.write_record(hdr, frame))
+            return false;
+        ++mPackets;
+        return true;
+    }
+
+    const SyntheticFeedOptions mOptions;
+    std::mt19937_64 mRandom;
+    PcapWriter mOutput;
+    Alpha_t<SESSION_LENGTH> mSession;
+    std::vector<GeneratedOrder> mLiveOrders;
+    Numeric8_t mNextOrderId = 1;
+    Numeric8_t mNextMatchId = 1;
+    Numeric4_t mSecond = 0;
+    Numeric4_t mNanoseconds = 0;
+    uint64_t mSequenceNumber = 1;
+    uint64_t mPackets = 0;
+    std::array<u_char, MAX_FRAME_LENGTH> mFrame;
+    std::size_t mPacketLength = 0;
+    std::size_t mPacketMessages = 0;
+    std::size_t mPacketTarget = 0;
+};
+
+} // namespace Midas::XSES::ITCH
@@ -0,0 +1,59 @@
+# cmake -DBINARY=<view_xses_iml> -DWORK_DIR=<dir> -P checkpoint_resume.cmake
+# a checkpoint restores the second, the live orders and the next sequence numbers it was taken with,
+# and resuming from it to the end of the capture lands on the same state as one straight pass
+
+if(NOT BINARY OR NOT WORK_DIR)
+    message(FATAL_ERROR "usage: cmake -DBINARY=<view_xses_iml> -DWORK_DIR=<dir> -P checkpoint_resume.cmake")
+endif()
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(source ${WORK_DIR}/checkpoint-source.pcap)
+set(prefix ${WORK_DIR}/checkpoint)
+file(GLOB stale ${prefix}.*.ckp)
+if(stale)
+    file(REMOVE ${stale})
+endif()
+
+execute_process(COMMAND ${BINARY} generate ${source} --messages 200000 --seed 5 --books 50
+    RESULT_VARIABLE result ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "generate failed: ${output}")
+endif()
+
+# straight pass, one line per checkpoint written and the state at the end of the capture
+execute_process(COMMAND ${BINARY} checkpoint ${source} ${prefix} --every 1
+    RESULT_VARIABLE result ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "checkpoint failed: ${output}")
+endif()
+string(REGEX MATCHALL "[^\n]*\\.ckp: [^\n]*" checkpoints "${output}")
+string(REGEX MATCH "end: [^\n]*" straightEnd "${output}")
+list(LENGTH checkpoints count)
+if(count LESS 2 OR NOT straightEnd)
+    message(FATAL_ERROR "expected at least two checkpoints and the final state: ${output}")
+endif()
+
+# the last checkpoint but one, with live orders and packets left after it
+math(EXPR index "${count} - 2")
+list(GET checkpoints ${index} checkpoint)
+string(REGEX MATCH "^(.*\\.([0-9]+)\\.ckp): (.*)$" matched "${checkpoint}")
+set(path ${CMAKE_MATCH_1})
+set(sequenceNumber ${CMAKE_MATCH_2})
+set(saved ${CMAKE_MATCH_3})
+if(NOT saved MATCHES "orders [1-9][0-9]*, next sequence number [^ ]+:${sequenceNumber}$")
+    message(FATAL_ERROR "checkpoint ${path} does not carry its sequence number or live orders: ${saved}")
+endif()
+
+execute_process(COMMAND ${BINARY} resume ${source} ${path} 0
+    RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE output)
+string(REGEX MATCH "restored in [0-9]+ us: ([^\n]*)" matched "${output}")
+if(NOT result EQUAL 0 OR NOT CMAKE_MATCH_1 STREQUAL saved)
+    message(FATAL_ERROR "restored state differs from the saved one\n  saved:    ${saved}\n  restored: ${output}")
+endif()
+
+execute_process(COMMAND ${BINARY} resume ${source} ${path}
+    RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE output)
+string(REGEX MATCH "end: [^\n]*" resumedEnd "${output}")
+message(STATUS "${saved} -> ${resumedEnd}")
+if(NOT result EQUAL 0 OR NOT resumedEnd STREQUAL straightEnd)
+    message(FATAL_ERROR "resumed run differs from the straight pass\n  straight: ${straightEnd}\n  resumed:  ${resumedEnd}")
+endif()
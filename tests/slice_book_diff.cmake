@@ -0,0 +1,27 @@
+# cmake -DBINARY=<view_xses_iml> -DWORK_DIR=<dir> -P slice_book_diff.cmake
+# an Order Book slice keeps every kept message under its original session and sequence number:
+# diffing the source against the slice reports the dropped messages as missing, never a mismatch or an extra
+
+if(NOT BINARY OR NOT WORK_DIR)
+    message(FATAL_ERROR "usage: cmake -DBINARY=<view_xses_iml> -DWORK_DIR=<dir> -P slice_book_diff.cmake")
+endif()
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(source ${WORK_DIR}/slice-source.pcap)
+set(slice ${WORK_DIR}/slice-book7.pcap)
+
+execute_process(COMMAND ${BINARY} generate ${source} --messages 200000 --seed 3 --books 50
+    RESULT_VARIABLE result ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "generate failed: ${output}")
+endif()
+execute_process(COMMAND ${BINARY} slice ${source} ${slice} --book 7
+    RESULT_VARIABLE result ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "slice failed: ${output}")
+endif()
+execute_process(COMMAND ${BINARY} diff ${source} ${slice} --window 1000000
+    RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE output)
+message(STATUS "${output}")
+if(NOT output MATCHES "matched: [1-9][0-9]*, mismatched: 0, missing: [1-9][0-9]*, extra: 0")
+    message(FATAL_ERROR "slice does not carry the source messages under their sequence numbers")
+endif()
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <ctime>
 #include <endian.h>
 #include <string>
 
@@ -45,4 +46,11 @@ std::string alpha_to_string(const Alpha_t<Size>& s)
     return std::string();
 }
 
+inline uint64_t monotonic_now_ns() noexcept
+{
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
 }  //namespace Midas::XSES::ITCH